@@ -6,6 +6,27 @@
 #include <iomanip>
 #include <fstream>
 #include <limits>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cctype>
+#include <cstdlib>
+#include <list>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <queue>
+#include <cstdio>
+#include <condition_variable>
+#include <future>
+#include <ctime>
+#include <deque>
 
 struct Student
 {
@@ -24,11 +45,267 @@ struct Student
 
 std::vector<Student> students;
 
+struct RosterShard
+{
+    std::string department;
+    std::string filename;
+    std::unordered_map<int, size_t> idIndex;
+    std::mutex mutex;
+};
+
+std::map<std::string, std::unique_ptr<RosterShard>> rosterShards;
+const std::string shardManifestFilename = "students.shards";
+
+struct StudentIndexEntry
+{
+    int id;
+    std::streamoff offset;
+};
+
+struct StudentNameIndexEntry
+{
+    uint64_t nameHash;
+    int id;
+};
+
+struct LazyStudentRegistry
+{
+    std::string filename;
+    std::ifstream file;
+    std::vector<StudentIndexEntry> idIndex;
+    std::vector<StudentNameIndexEntry> nameIndex;
+    size_t cacheCapacity = 0;
+    std::list<Student> cache;
+    std::unordered_map<int, std::list<Student>::iterator> cacheIndex;
+};
+
+LazyStudentRegistry lazyRegistry;
+
+constexpr size_t archiveBlockRecords = 1024;
+constexpr size_t archiveMaxMatchLength = 65535;
+constexpr size_t archiveMaxExpansion = 16384;
+const char archiveMagic[4] = { 'S', 'A', 'M', 'A' };
+constexpr char archiveVersion = 1;
+
+struct ArchiveBlockInfo
+{
+    int firstId;
+    uint64_t offset;
+    uint64_t compressedSize;
+    uint64_t rawSize;
+};
+
+struct ArchiveHeader
+{
+    std::vector<std::string> departments;
+    std::vector<std::string> majors;
+    std::vector<ArchiveBlockInfo> blocks;
+    std::streamoff dataStart = 0;
+};
+
+constexpr size_t diffRunRecords = 250000;
+
+struct SortedRosterReader
+{
+    std::vector<std::string> runFiles;
+    std::vector<std::unique_ptr<std::ifstream>> runs;
+    std::vector<Student> memoryRun;
+    size_t memoryPos = 0;
+    std::vector<Student> heads;
+    std::priority_queue<std::pair<int, size_t>, std::vector<std::pair<int, size_t>>,
+        std::greater<std::pair<int, size_t>>> heap;
+};
+
+struct RosterDiffSummary
+{
+    size_t added = 0;
+    size_t removed = 0;
+    size_t changed = 0;
+};
+
+struct RosterFingerprint
+{
+    size_t count = 0;
+    uint64_t sum = 0;
+
+    void add(uint64_t hash)
+    {
+        ++count;
+        sum += hash;
+    }
+
+    void remove(uint64_t hash)
+    {
+        --count;
+        sum -= hash;
+    }
+
+    bool operator==(const RosterFingerprint& other) const
+    {
+        return count == other.count && sum == other.sum;
+    }
+};
+
+struct GradeCheckpoint
+{
+    std::time_t time;
+    size_t logOffset;
+    bool replacesRoster;
+    RosterFingerprint fingerprint;
+    std::vector<std::string> strings;
+    std::string compressed;
+    size_t rawSize;
+};
+
+enum class StudentChangeKind
+{
+    Upsert,
+    RemoveById,
+    ReplaceAll,
+    Checkpoint,
+    Flush
+};
+
+struct StudentChange
+{
+    StudentChangeKind kind;
+    Student student;
+    std::unique_ptr<std::vector<Student>> roster;
+    std::unique_ptr<GradeCheckpoint> checkpoint;
+    std::unique_ptr<std::promise<bool>> flushed;
+    std::string history;
+    StudentChange* next = nullptr;
+};
+
+struct BackgroundPersistence
+{
+    std::string filename;
+    std::thread worker;
+    std::atomic<StudentChange*> pending{ nullptr };
+    std::atomic<bool> stopping{ false };
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::vector<Student> mirror;
+    RosterFingerprint mirrorFingerprint;
+    std::atomic<bool> mirrorDiverged{ false };
+    std::ofstream historyFile;
+    std::atomic<bool> historyWriteFailed{ false };
+    bool writeFailed = false;
+};
+
+BackgroundPersistence persistence;
+
+constexpr size_t gradeCheckpointInterval = 1024;
+const std::string gradeHistoryFilename = "students.hist";
+const char gradeHistoryMagic[4] = { 'S', 'A', 'M', 'H' };
+constexpr char gradeHistoryVersion = 1;
+
+enum class GradeChangeKind
+{
+    Added,
+    Removed,
+    Modified
+};
+
+struct GradeChange
+{
+    GradeChangeKind kind;
+    std::time_t time;
+    int id;
+    uint32_t changedFields;
+    std::string name;
+    uint32_t department;
+    uint32_t major;
+    int scores[5];
+};
+
+struct GradeHistory
+{
+    std::string filename;
+    std::string log;
+    size_t savedLogSize = 0;
+    size_t savedStringCount = 0;
+    std::time_t lastTime = 0;
+    size_t changesSinceCheckpoint = 0;
+    std::vector<GradeCheckpoint> checkpoints;
+    std::mutex checkpointMutex;
+    RosterFingerprint fingerprint;
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> codes;
+};
+
+struct GradeHistoryEntry
+{
+    std::time_t time;
+    bool present;
+    Student student;
+};
+
+GradeHistory gradeHistory;
+
+constexpr size_t transcriptBatchRecords = 64;
+
+const char* const defaultTranscriptTemplate =
+    "Student Transcript\n"
+    "==================\n"
+    "Name: {name}\n"
+    "ID: {id}\n"
+    "Department: {department}\n"
+    "Major: {major}\n"
+    "\n"
+    "Course 1: {score1}\n"
+    "Course 2: {score2}\n"
+    "Course 3: {score3}\n"
+    "Course 4: {score4}\n"
+    "Course 5: {score5}\n"
+    "\n"
+    "Total Score: {total}\n"
+    "Average Score: {average}\n";
+
+enum class TranscriptField
+{
+    None,
+    Name,
+    Id,
+    Department,
+    Major,
+    Score1,
+    Score2,
+    Score3,
+    Score4,
+    Score5,
+    Total,
+    Average
+};
+
+struct TranscriptSegment
+{
+    std::string literal;
+    TranscriptField field;
+};
+
+struct TranscriptBatch
+{
+    size_t first = 0;
+    size_t count = 0;
+    std::string text;
+    std::vector<size_t> ends;
+};
+
+struct TranscriptQueue
+{
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<TranscriptBatch*> batches;
+    size_t producers = 0;
+};
+
 bool isDuplicateName(const std::string& name);
 bool isDuplicateId(int id);
+size_t removeDuplicateIds(std::vector<Student>& records);
 bool addStudent(std::string name, int id, std::string department,
     std::string major, const std::vector<int>& scores);
-bool deleteStudentByName(const std::string& name);
+bool deleteStudentByName(const std::string& name, int& deletedId);
 bool deleteStudentById(int id);
 bool modifyStudentByName(const std::string& name,
     const std::string& department,
@@ -51,6 +328,105 @@ void sortStudentsByScore(int courseIndex, bool ascending = true);
 void printStudentTable(const std::vector<Student>& studentsToPrint);
 void loadStudentsFromFile(const std::string& filename);
 void saveStudentsToFile(const std::string& filename);
+bool readStudentRecord(std::istream& in, Student& student);
+void readStudentRecords(std::istream& in, std::vector<Student>& records);
+void writeStudentRecord(std::ostream& out, const Student& student);
+size_t getStudentRecordTextSize(const Student& student);
+void writeStudentRecords(std::ostream& out, const std::vector<Student>& records);
+
+void runInParallel(size_t taskCount, const std::function<void(size_t)>& task);
+std::string getShardFileName(const std::string& manifestFilename, const std::string& department);
+RosterShard& getOrCreateShard(const std::string& department);
+Student* lookupStudentInShards(int id);
+void addStudentToShard(size_t position);
+void removeStudentFromShard(size_t position);
+void updateStudentInShard(const std::string& previousDepartment, size_t position);
+void partitionStudentsIntoShards();
+void saveStudentsToShards(const std::string& manifestFilename);
+bool loadStudentsFromShards(const std::string& manifestFilename);
+std::vector<Student> queryShards(const std::string& department,
+    const std::function<bool(const Student&)>& predicate);
+bool findStudentInShards(int id, Student& result);
+
+uint64_t hashStudentName(const char* name, size_t length);
+bool openLazyRegistry(const std::string& filename, size_t cacheCapacity);
+Student* fetchRegistryRecord(int id, bool& unreadable);
+Student* fetchStudentById(int id);
+Student* fetchStudentByName(const std::string& name);
+void browseLazyRegistry(const std::string& filename, bool standalone);
+
+void appendVarint(std::string& out, uint64_t value);
+bool readVarint(const std::string& in, size_t& pos, uint64_t& value);
+bool readVarint(std::istream& in, uint64_t& value);
+std::string compressBlock(const std::string& in);
+bool decompressBlock(const std::string& in, std::string& out, size_t rawSize);
+std::string encodeArchiveBlock(const Student* records, size_t count,
+    const std::unordered_map<std::string, uint32_t>& departmentCodes,
+    const std::unordered_map<std::string, uint32_t>& majorCodes);
+bool decodeArchiveBlock(const std::string& raw, const std::vector<std::string>& departments,
+    const std::vector<std::string>& majors, std::vector<Student>& records);
+bool decodeArchiveRecord(const std::string& raw, const std::vector<std::string>& departments,
+    const std::vector<std::string>& majors, int id, Student& student, bool& found);
+bool readArchiveHeader(std::istream& in, ArchiveHeader& header);
+bool readArchiveBlock(std::istream& in, const ArchiveHeader& header, size_t blockIndex,
+    std::vector<Student>& records);
+void saveStudentsToArchive(const std::string& filename);
+bool loadStudentsFromArchive(const std::string& filename);
+bool readArchivedStudent(const std::string& filename, int id, Student& result);
+
+bool openSortedRoster(const std::string& filename, const std::string& runPrefix,
+    SortedRosterReader& reader);
+bool nextSortedStudent(SortedRosterReader& reader, Student& student);
+void closeSortedRoster(SortedRosterReader& reader);
+bool isSameStudentRecord(const Student& a, const Student& b);
+bool diffRosterFiles(const std::string& baseFilename, const std::string& otherFilename,
+    const std::string& diffFilename, RosterDiffSummary& summary);
+bool applyRosterDiff(const std::string& diffFilename, RosterDiffSummary& summary);
+
+void startBackgroundPersistence(const std::string& filename);
+void queueStudentChange(StudentChange* change);
+void queueStudentUpsert(const Student& student);
+void queueStudentRemovalById(int id);
+void queueRosterSnapshot();
+bool flushBackgroundPersistence();
+bool stopBackgroundPersistence();
+void runPersistenceWorker();
+void checkBackgroundPersistence();
+
+uint64_t hashStudentRecord(const std::string& name, int id, const std::string& department,
+    const std::string& major, const std::vector<int>& scores);
+uint64_t hashStudentRecord(const Student& student);
+RosterFingerprint fingerprintRoster(const std::vector<Student>& roster);
+uint32_t internHistoryString(const std::string& value);
+void requestGradeCheckpoint(bool replacesRoster);
+void buildGradeCheckpoint(const std::vector<Student>& roster, GradeCheckpoint& checkpoint);
+void appendGradeChangeHeader(GradeChangeKind kind, uint32_t changedFields, int id);
+bool readGradeHistory(const std::string& contents);
+bool trimGradeHistory();
+bool writeGradeHistory(const std::string& filename);
+void appendGradeCheckpointRecord(std::string& out, const GradeCheckpoint& checkpoint);
+void takeUnsavedGradeHistory(std::string& out);
+void startGradeHistory(const std::string& filename);
+void recordStudentAdded(const Student& student);
+void recordStudentRemoved(const Student& student);
+void recordStudentModified(const Student& student, const std::string& department,
+    const std::string& major, const std::vector<int>& scores);
+void recordRosterReplaced();
+bool readGradeChange(const std::string& log, size_t& pos, std::time_t& time, GradeChange& change);
+void applyGradeChange(const GradeChange& change, std::map<int, Student>& roster);
+bool restoreGradeCheckpoint(const GradeCheckpoint& checkpoint, std::map<int, Student>& roster);
+bool restoreGradeCheckpointRecord(const GradeCheckpoint& checkpoint, int id, std::map<int, Student>& roster);
+std::vector<Student> getRosterAsOf(std::time_t time);
+std::vector<GradeHistoryEntry> getGradeHistory(int id);
+
+std::vector<TranscriptSegment> parseTranscriptTemplate(const std::string& text);
+void renderTranscript(const std::vector<TranscriptSegment>& segments, const Student& student,
+    std::string& buffer);
+void pushTranscriptBatch(TranscriptQueue& queue, TranscriptBatch* batch);
+TranscriptBatch* popTranscriptBatch(TranscriptQueue& queue);
+void closeTranscriptQueue(TranscriptQueue& queue);
+bool generateTranscripts(const std::string& templateFilename, const std::string& outputPrefix,
+    const std::string& department);
 
 void clearScreen()
 {
@@ -73,7 +449,8 @@ void displayMainMenu()
     std::cout << "4. Find Student\n";
     std::cout << "5. Sort Students\n";
     std::cout << "6. Print Student List\n";
-    std::cout << "7. Exit\n\n";
+    std::cout << "7. Exit\n";
+    std::cout << "8. Data Tools\n\n";
     std::cout << "Enter your choice: ";
 }
 
@@ -138,6 +515,37 @@ void displaySortByCourseScoreMenu()
     std::cout << "Enter your choice: ";
 }
 
+void displayDataToolsMenu()
+{
+    clearScreen();
+    std::cout << "Data Tools\n\n";
+    std::cout << "1. Save Roster Sharded by Department\n";
+    std::cout << "2. Load Sharded Roster\n";
+    std::cout << "3. List Students in Department\n";
+    std::cout << "4. Find Student by ID Across Shards\n";
+    std::cout << "5. Browse Registry On Demand\n";
+    std::cout << "6. Archive Roster\n";
+    std::cout << "7. Load Archived Roster\n";
+    std::cout << "8. Read Archived Student by ID\n";
+    std::cout << "9. Diff Two Roster Files\n";
+    std::cout << "10. Apply Roster Diff\n";
+    std::cout << "11. Show Roster As Of Earlier Time\n";
+    std::cout << "12. Show Grade History of Student\n";
+    std::cout << "13. Generate Transcripts\n";
+    std::cout << "14. Back to Main Menu\n\n";
+    std::cout << "Enter your choice: ";
+}
+
+void displayLazyRegistryMenu(bool standalone)
+{
+    clearScreen();
+    std::cout << "Browse Registry On Demand\n\n";
+    std::cout << "1. Find by Name\n";
+    std::cout << "2. Find by ID\n";
+    std::cout << (standalone ? "3. Exit\n\n" : "3. Back to Data Tools\n\n");
+    std::cout << "Enter your choice: ";
+}
+
 bool isDuplicateName(const std::string& name)
 {
     for (const auto& student : students)
@@ -152,14 +560,31 @@ bool isDuplicateName(const std::string& name)
 
 bool isDuplicateId(int id)
 {
-    for (const auto& student : students)
+    return lookupStudentInShards(id) != nullptr;
+}
+
+size_t removeDuplicateIds(std::vector<Student>& records)
+{
+    std::unordered_set<int> seen;
+    size_t count = 0;
+    for (size_t i = 0; i < records.size(); ++i)
     {
-        if (student.id == id)
+        if (seen.insert(records[i].id).second)
         {
-            return true;
+            if (i != count)
+            {
+                records[count] = std::move(records[i]);
+            }
+            ++count;
         }
     }
-    return false;
+    size_t removed = records.size() - count;
+    records.resize(count);
+    if (removed > 0)
+    {
+        std::cerr << "Error: Skipped " << removed << " records with duplicate IDs.\n";
+    }
+    return removed;
 }
 
 bool addStudent(std::string name, int id, std::string department,
@@ -211,17 +636,22 @@ bool addStudent(std::string name, int id, std::string department,
 
     students.emplace_back(Student{ std::move(name), id, std::move(department), std::move(major), scores, 0 });
     students.back().calculateTotalScore();
+    recordStudentAdded(students.back());
+    addStudentToShard(students.size() - 1);
     std::cout << "Student added successfully.\n";
     return true;
 }
 
-bool deleteStudentByName(const std::string& name)
+bool deleteStudentByName(const std::string& name, int& deletedId)
 {
     auto it = std::find_if(students.begin(), students.end(),
         [&name](const Student& s)
         { return s.name == name; });
     if (it != students.end())
     {
+        deletedId = it->id;
+        recordStudentRemoved(*it);
+        removeStudentFromShard(it - students.begin());
         students.erase(it);
         std::cout << "Student deleted successfully.\n";
         return true;
@@ -236,12 +666,13 @@ bool deleteStudentByName(const std::string& name)
 
 bool deleteStudentById(int id)
 {
-    auto it = std::find_if(students.begin(), students.end(),
-        [&id](const Student& s)
-        { return s.id == id; });
-    if (it != students.end())
+    Student* student = lookupStudentInShards(id);
+    if (student)
     {
-        students.erase(it);
+        size_t position = student - students.data();
+        recordStudentRemoved(*student);
+        removeStudentFromShard(position);
+        students.erase(students.begin() + position);
         std::cout << "Student deleted successfully.\n";
         return true;
     }
@@ -262,10 +693,13 @@ bool modifyStudentByName(const std::string& name,
     Student* student = findStudentByName(name);
     if (student)
     {
+        recordStudentModified(*student, department, major, scores);
+        std::string previousDepartment = student->department;
         student->department = department;
         student->major = major;
         student->scores = scores;
         student->calculateTotalScore();
+        updateStudentInShard(previousDepartment, student - students.data());
         std::cout << "Student modified successfully.\n";
         return true;
     }
@@ -282,10 +716,13 @@ bool modifyStudentById(int id,
     Student* student = findStudentById(id);
     if (student)
     {
+        recordStudentModified(*student, department, major, scores);
+        std::string previousDepartment = student->department;
         student->department = department;
         student->major = major;
         student->scores = scores;
         student->calculateTotalScore();
+        updateStudentInShard(previousDepartment, student - students.data());
         std::cout << "Student modified successfully.\n";
         return true;
     }
@@ -309,12 +746,10 @@ Student* findStudentByName(const std::string& name)
 
 Student* findStudentById(int id)
 {
-    for (auto& student : students)
+    Student* student = lookupStudentInShards(id);
+    if (student)
     {
-        if (student.id == id)
-        {
-            return &student;
-        }
+        return student;
     }
     std::cerr << "Error: Student with ID " << id << " not found.\n";
     waitForEnter();
@@ -348,6 +783,7 @@ void sortStudentsById()
     std::sort(students.begin(), students.end(),
         [](const Student& a, const Student& b)
         { return a.id < b.id; });
+    partitionStudentsIntoShards();
     std::cout << "Students sorted by ID.\n";
     printStudentTable(students);
     waitForEnter();
@@ -360,6 +796,7 @@ void sortStudentsByTotalScore(bool ascending)
         {
             return ascending ? (a.totalScore < b.totalScore) : (a.totalScore > b.totalScore);
         });
+    partitionStudentsIntoShards();
     std::cout << "Students sorted by total score ("
         << (ascending ? "ascending" : "descending") << ").\n";
     printStudentTable(students);
@@ -384,6 +821,7 @@ void sortStudentsByScore(int courseIndex, bool ascending)
             return ascending ? (a.scores[courseIndex] < b.scores[courseIndex])
                 : (a.scores[courseIndex] > b.scores[courseIndex]);
         });
+    partitionStudentsIntoShards();
     std::cout << "Students sorted by course " << courseIndex + 1 << " score ("
         << (ascending ? "ascending" : "descending") << "):\n";
     printStudentTable(students);
@@ -440,18 +878,9 @@ void loadStudentsFromFile(const std::string& filename)
     }
 
     students.clear();
-
-    Student student;
-    while (inFile >> student.name >> student.id >> student.department >> student.major)
-    {
-        student.scores.resize(5);
-        for (int i = 0; i < 5; ++i)
-        {
-            inFile >> student.scores[i];
-        }
-        student.calculateTotalScore();
-        students.push_back(student);
-    }
+    readStudentRecords(inFile, students);
+    removeDuplicateIds(students);
+    partitionStudentsIntoShards();
 
     inFile.close();
     std::cout << "Data loaded from " << filename << ".\n";
@@ -468,105 +897,2667 @@ void saveStudentsToFile(const std::string& filename)
         return;
     }
 
-    for (const auto& student : students)
-    {
-        outFile << student.name << " " << student.id << " "
-            << student.department << " " << student.major << " ";
-        for (int score : student.scores)
-        {
-            outFile << score << " ";
-        }
-        outFile << "\n";
-    }
+    writeStudentRecords(outFile, students);
 
     outFile.close();
     std::cout << "Data saved to " << filename << ".\n";
     waitForEnter();
 }
 
-int main()
+bool readStudentRecord(std::istream& in, Student& student)
 {
-    clearScreen();
-    std::cout << "Welcome to Student Management System\n";
-    std::cout << "Please maximize the console window to ensure proper display and prevent formatting issues." << std::endl;
+    if (!(in >> student.name >> student.id >> student.department >> student.major))
+    {
+        return false;
+    }
+    student.scores.resize(5);
+    for (int i = 0; i < 5; ++i)
+    {
+        in >> student.scores[i];
+    }
+    student.calculateTotalScore();
+    return true;
+}
 
-    std::cout << "Loading data from students.dat...\n";
-    loadStudentsFromFile("students.dat");
+void readStudentRecords(std::istream& in, std::vector<Student>& records)
+{
+    Student student;
+    while (readStudentRecord(in, student))
+    {
+        records.push_back(student);
+    }
+}
 
-    int choice;
-    while (true)
+void writeStudentRecord(std::ostream& out, const Student& student)
+{
+    out << student.name << " " << student.id << " "
+        << student.department << " " << student.major << " ";
+    for (int score : student.scores)
     {
-        displayMainMenu();
-        if (!(std::cin >> choice))
-        {
-            clearScreen();
-            std::cerr << "Invalid input. Please enter a number.\n";
-            std::cin.clear();
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            waitForEnter();
-            continue;
-        }
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        switch (choice)
-        {
-        case 1:
-        {
-            clearScreen();
-            std::string name, department, major;
-            int id;
-            std::vector<int> scores(5);
+        out << score << " ";
+    }
+    out << "\n";
+}
 
-            std::cout << "Enter name: ";
-            std::getline(std::cin, name);
+size_t getStudentRecordTextSize(const Student& student)
+{
+    size_t size = student.name.size() + std::to_string(student.id).size() +
+        student.department.size() + student.major.size() + 5;
+    for (int score : student.scores)
+    {
+        size += std::to_string(score).size() + 1;
+    }
+    return size;
+}
 
-            std::cout << "Enter ID: ";
-            std::cin >> id;
-            std::cout << "Enter department: ";
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            std::getline(std::cin, department);
+void writeStudentRecords(std::ostream& out, const std::vector<Student>& records)
+{
+    for (const auto& student : records)
+    {
+        writeStudentRecord(out, student);
+    }
+}
 
-            std::cout << "Enter major: ";
-            std::getline(std::cin, major);
+void runInParallel(size_t taskCount, const std::function<void(size_t)>& task)
+{
+    size_t workerCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    workerCount = std::min(workerCount, taskCount);
 
-            std::cout << "Enter scores (5 courses): ";
-            for (int i = 0; i < 5; ++i)
+    std::atomic<size_t> nextTask(0);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back([&nextTask, taskCount, &task]()
             {
-                std::cin >> scores[i];
-            }
+                size_t index;
+                while ((index = nextTask.fetch_add(1)) < taskCount)
+                {
+                    task(index);
+                }
+            });
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
 
-            if (addStudent(name, id, department, major, scores))
+std::string getShardFileName(const std::string& manifestFilename, const std::string& department)
+{
+    std::string base = manifestFilename.substr(0, manifestFilename.find_last_of('.'));
+    std::string suffix;
+    for (char c : department)
+    {
+        suffix += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+    return base + "_" + suffix + ".dat";
+}
+
+RosterShard& getOrCreateShard(const std::string& department)
+{
+    auto& shard = rosterShards[department];
+    if (!shard)
+    {
+        std::string filename = getShardFileName(shardManifestFilename, department);
+        std::string candidate = filename;
+        for (int uses = 1;; ++uses)
+        {
+            auto taken = std::find_if(rosterShards.begin(), rosterShards.end(),
+                [&candidate](const std::pair<const std::string, std::unique_ptr<RosterShard>>& entry)
+                { return entry.second && entry.second->filename == candidate; });
+            if (taken == rosterShards.end())
             {
-                saveStudentsToFile("students.dat");
+                break;
             }
-            break;
+            candidate = filename;
+            candidate.insert(candidate.size() - 4, "_" + std::to_string(uses));
         }
-        case 2:
+
+        shard.reset(new RosterShard);
+        shard->department = department;
+        shard->filename = candidate;
+    }
+    return *shard;
+}
+
+Student* lookupStudentInShards(int id)
+{
+    for (auto& entry : rosterShards)
+    {
+        RosterShard& shard = *entry.second;
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.idIndex.find(id);
+        if (it != shard.idIndex.end())
         {
-            displayDeleteStudentMenu();
-            std::cin >> choice;
-            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            clearScreen();
-            switch (choice)
+            return &students[it->second];
+        }
+    }
+    return nullptr;
+}
+
+void addStudentToShard(size_t position)
+{
+    RosterShard& shard = getOrCreateShard(students[position].department);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.idIndex[students[position].id] = position;
+}
+
+void removeStudentFromShard(size_t position)
+{
+    for (auto entry = rosterShards.begin(); entry != rosterShards.end();)
+    {
+        RosterShard& shard = *entry->second;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.department == students[position].department)
             {
-            case 1:
+                shard.idIndex.erase(students[position].id);
+            }
+            for (auto& index : shard.idIndex)
             {
-                std::string name;
-                std::cout << "Enter name: ";
-                std::getline(std::cin, name);
-                if (deleteStudentByName(name))
+                if (index.second > position)
                 {
-                    saveStudentsToFile("students.dat");
+                    --index.second;
                 }
-                break;
             }
-            case 2:
-            {
-                int id;
-                std::cout << "Enter ID: ";
-                std::cin >> id;
-                if (deleteStudentById(id))
+        }
+        if (shard.idIndex.empty())
+        {
+            entry = rosterShards.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+}
+
+void updateStudentInShard(const std::string& previousDepartment, size_t position)
+{
+    if (previousDepartment == students[position].department)
+    {
+        return;
+    }
+
+    auto found = rosterShards.find(previousDepartment);
+    if (found != rosterShards.end())
+    {
+        bool empty;
+        {
+            std::lock_guard<std::mutex> lock(found->second->mutex);
+            found->second->idIndex.erase(students[position].id);
+            empty = found->second->idIndex.empty();
+        }
+        if (empty)
+        {
+            rosterShards.erase(found);
+        }
+    }
+    addStudentToShard(position);
+}
+
+void partitionStudentsIntoShards()
+{
+    for (auto& entry : rosterShards)
+    {
+        entry.second->idIndex.clear();
+    }
+    for (size_t i = 0; i < students.size(); ++i)
+    {
+        getOrCreateShard(students[i].department).idIndex[students[i].id] = i;
+    }
+
+    for (auto entry = rosterShards.begin(); entry != rosterShards.end();)
+    {
+        if (entry->second->idIndex.empty())
+        {
+            entry = rosterShards.erase(entry);
+        }
+        else
+        {
+            ++entry;
+        }
+    }
+}
+
+std::vector<size_t> getShardPositions(const RosterShard& shard)
+{
+    std::vector<size_t> positions;
+    positions.reserve(shard.idIndex.size());
+    for (const auto& index : shard.idIndex)
+    {
+        positions.push_back(index.second);
+    }
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+void saveStudentsToShards(const std::string& manifestFilename)
+{
+    std::vector<RosterShard*> shards;
+    for (auto& entry : rosterShards)
+    {
+        shards.push_back(entry.second.get());
+    }
+
+    std::vector<char> failed(shards.size(), 0);
+    runInParallel(shards.size(), [&shards, &failed](size_t i)
+        {
+            RosterShard* shard = shards[i];
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            std::ofstream outFile(shard->filename);
+            for (size_t position : getShardPositions(*shard))
+            {
+                writeStudentRecord(outFile, students[position]);
+            }
+            outFile.close();
+            failed[i] = !outFile;
+        });
+
+    bool complete = true;
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        if (failed[i])
+        {
+            std::cerr << "Error: Unable to write shard file " << shards[i]->filename << ".\n";
+            complete = false;
+        }
+    }
+    if (!complete)
+    {
+        std::cerr << "Error: Manifest " << manifestFilename << " was not updated.\n";
+        waitForEnter();
+        return;
+    }
+
+    std::ofstream manifest(manifestFilename);
+    if (!manifest)
+    {
+        std::cerr << "Error: Unable to open file " << manifestFilename << " for writing.\n";
+        waitForEnter();
+        return;
+    }
+    for (const RosterShard* shard : shards)
+    {
+        manifest << shard->department << " " << shard->filename << "\n";
+    }
+    manifest.close();
+    if (!manifest)
+    {
+        std::cerr << "Error: Unable to write file " << manifestFilename << ".\n";
+        waitForEnter();
+        return;
+    }
+
+    std::cout << "Data saved to " << shards.size() << " shards listed in " << manifestFilename << ".\n";
+    waitForEnter();
+}
+
+bool loadStudentsFromShards(const std::string& manifestFilename)
+{
+    std::ifstream manifest(manifestFilename);
+    if (!manifest)
+    {
+        std::cerr << "Error: Unable to open file " << manifestFilename << " for reading.\n";
+        waitForEnter();
+        return false;
+    }
+
+    std::map<std::string, std::unique_ptr<RosterShard>> loadedShards;
+    std::vector<RosterShard*> shards;
+    std::string department, filename;
+    while (manifest >> department >> filename)
+    {
+        auto& shard = loadedShards[department];
+        if (shard)
+        {
+            std::cerr << "Error: Department " << department << " is listed more than once in "
+                << manifestFilename << ".\n";
+            waitForEnter();
+            return false;
+        }
+        shard.reset(new RosterShard);
+        shard->department = department;
+        shard->filename = filename;
+        shards.push_back(shard.get());
+    }
+    manifest.close();
+
+    std::vector<std::vector<Student>> shardRecords(shards.size());
+    std::vector<char> failed(shards.size(), 0);
+    runInParallel(shards.size(), [&shards, &shardRecords, &failed](size_t i)
+        {
+            std::ifstream inFile(shards[i]->filename);
+            if (!inFile)
+            {
+                failed[i] = 1;
+                return;
+            }
+            readStudentRecords(inFile, shardRecords[i]);
+        });
+
+    std::vector<Student> loaded;
+    bool complete = true;
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        if (failed[i])
+        {
+            std::cerr << "Error: Unable to open shard file " << shards[i]->filename << " for reading.\n";
+            complete = false;
+            continue;
+        }
+        loaded.insert(loaded.end(), shardRecords[i].begin(), shardRecords[i].end());
+    }
+    if (!complete)
+    {
+        std::cerr << "Error: Roster was not loaded from " << manifestFilename << ".\n";
+        waitForEnter();
+        return false;
+    }
+
+    removeDuplicateIds(loaded);
+    students.swap(loaded);
+    rosterShards.swap(loadedShards);
+    partitionStudentsIntoShards();
+    std::cout << "Data loaded from " << shards.size() << " shards listed in " << manifestFilename << ".\n";
+    waitForEnter();
+    return true;
+}
+
+std::vector<Student> queryShards(const std::string& department,
+    const std::function<bool(const Student&)>& predicate)
+{
+    std::vector<RosterShard*> shards;
+    if (department.empty())
+    {
+        for (auto& entry : rosterShards)
+        {
+            shards.push_back(entry.second.get());
+        }
+    }
+    else
+    {
+        auto it = rosterShards.find(department);
+        if (it != rosterShards.end())
+        {
+            shards.push_back(it->second.get());
+        }
+    }
+
+    std::vector<std::vector<Student>> partialResults(shards.size());
+    runInParallel(shards.size(), [&shards, &partialResults, &predicate](size_t i)
+        {
+            std::lock_guard<std::mutex> lock(shards[i]->mutex);
+            for (size_t position : getShardPositions(*shards[i]))
+            {
+                if (predicate(students[position]))
+                {
+                    partialResults[i].push_back(students[position]);
+                }
+            }
+        });
+
+    std::vector<Student> results;
+    for (auto& partial : partialResults)
+    {
+        results.insert(results.end(), partial.begin(), partial.end());
+    }
+    return results;
+}
+
+bool findStudentInShards(int id, Student& result)
+{
+    Student* student = lookupStudentInShards(id);
+    if (!student)
+    {
+        std::cerr << "Error: Student with ID " << id << " not found in any shard.\n";
+        return false;
+    }
+    result = *student;
+    return true;
+}
+
+uint64_t hashStudentName(const char* name, size_t length)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; ++i)
+    {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool openLazyRegistry(const std::string& filename, size_t cacheCapacity)
+{
+    lazyRegistry.file.close();
+    lazyRegistry.file.clear();
+    lazyRegistry.file.open(filename, std::ios::binary);
+    if (!lazyRegistry.file)
+    {
+        std::cerr << "Error: Unable to open file " << filename << " for reading.\n";
+        waitForEnter();
+        return false;
+    }
+
+    lazyRegistry.filename = filename;
+    lazyRegistry.idIndex.clear();
+    lazyRegistry.nameIndex.clear();
+    lazyRegistry.cache.clear();
+    lazyRegistry.cacheIndex.clear();
+    lazyRegistry.cacheCapacity = std::max<size_t>(1, cacheCapacity);
+
+    std::string line;
+    std::streamoff offset = 0;
+    while (std::getline(lazyRegistry.file, line))
+    {
+        size_t nameBegin = line.find_first_not_of(" \t\r");
+        if (nameBegin != std::string::npos)
+        {
+            size_t nameEnd = line.find_first_of(" \t", nameBegin);
+            if (nameEnd != std::string::npos)
+            {
+                int id = std::atoi(line.c_str() + nameEnd);
+                lazyRegistry.idIndex.push_back({ id, offset + static_cast<std::streamoff>(nameBegin) });
+                lazyRegistry.nameIndex.push_back({ hashStudentName(line.data() + nameBegin, nameEnd - nameBegin), id });
+            }
+        }
+        offset += static_cast<std::streamoff>(line.size()) + 1;
+    }
+    lazyRegistry.file.clear();
+
+    std::sort(lazyRegistry.idIndex.begin(), lazyRegistry.idIndex.end(),
+        [](const StudentIndexEntry& a, const StudentIndexEntry& b)
+        { return a.id < b.id; });
+    lazyRegistry.idIndex.shrink_to_fit();
+    std::sort(lazyRegistry.nameIndex.begin(), lazyRegistry.nameIndex.end(),
+        [](const StudentNameIndexEntry& a, const StudentNameIndexEntry& b)
+        { return a.nameHash < b.nameHash; });
+    lazyRegistry.nameIndex.shrink_to_fit();
+    return true;
+}
+
+Student* fetchRegistryRecord(int id, bool& unreadable)
+{
+    auto cached = lazyRegistry.cacheIndex.find(id);
+    if (cached != lazyRegistry.cacheIndex.end())
+    {
+        lazyRegistry.cache.splice(lazyRegistry.cache.begin(), lazyRegistry.cache, cached->second);
+        return &lazyRegistry.cache.front();
+    }
+
+    auto entry = std::lower_bound(lazyRegistry.idIndex.begin(), lazyRegistry.idIndex.end(), id,
+        [](const StudentIndexEntry& e, int value)
+        { return e.id < value; });
+    if (entry == lazyRegistry.idIndex.end() || entry->id != id)
+    {
+        return nullptr;
+    }
+
+    Student student;
+    lazyRegistry.file.clear();
+    lazyRegistry.file.seekg(entry->offset);
+    if (!readStudentRecord(lazyRegistry.file, student))
+    {
+        unreadable = true;
+        return nullptr;
+    }
+
+    lazyRegistry.cache.push_front(std::move(student));
+    lazyRegistry.cacheIndex[id] = lazyRegistry.cache.begin();
+    if (lazyRegistry.cache.size() > lazyRegistry.cacheCapacity)
+    {
+        lazyRegistry.cacheIndex.erase(lazyRegistry.cache.back().id);
+        lazyRegistry.cache.pop_back();
+    }
+    return &lazyRegistry.cache.front();
+}
+
+Student* fetchStudentById(int id)
+{
+    bool unreadable = false;
+    Student* student = fetchRegistryRecord(id, unreadable);
+    if (student == nullptr)
+    {
+        if (unreadable)
+        {
+            std::cerr << "Error: Unable to read record for ID " << id << " from "
+                << lazyRegistry.filename << ".\n";
+        }
+        else
+        {
+            std::cerr << "Error: Student with ID " << id << " not found.\n";
+        }
+        waitForEnter();
+    }
+    return student;
+}
+
+Student* fetchStudentByName(const std::string& name)
+{
+    uint64_t nameHash = hashStudentName(name.data(), name.size());
+    auto first = std::lower_bound(lazyRegistry.nameIndex.begin(), lazyRegistry.nameIndex.end(), nameHash,
+        [](const StudentNameIndexEntry& e, uint64_t value)
+        { return e.nameHash < value; });
+    bool unreadable = false;
+    for (auto it = first; it != lazyRegistry.nameIndex.end() && it->nameHash == nameHash; ++it)
+    {
+        Student* student = fetchRegistryRecord(it->id, unreadable);
+        if (student != nullptr && student->name == name)
+        {
+            return student;
+        }
+    }
+    if (unreadable)
+    {
+        std::cerr << "Error: Unable to read record for name " << name << " from "
+            << lazyRegistry.filename << ".\n";
+    }
+    else
+    {
+        std::cerr << "Error: Student with name " << name << " not found.\n";
+    }
+    waitForEnter();
+    return nullptr;
+}
+
+void browseLazyRegistry(const std::string& filename, bool standalone)
+{
+    auto start = std::chrono::steady_clock::now();
+    if (!openLazyRegistry(filename, 1024))
+    {
+        return;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << "Indexed " << lazyRegistry.idIndex.size() << " records from " << filename
+        << " in " << elapsed.count() << " ms.\n";
+    waitForEnter();
+
+    int choice = 0;
+    while (choice != 3)
+    {
+        displayLazyRegistryMenu(standalone);
+        if (!(std::cin >> choice))
+        {
+            std::cin.clear();
+            choice = 0;
+        }
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        clearScreen();
+        Student* student = nullptr;
+        switch (choice)
+        {
+        case 1:
+        {
+            std::string name;
+            std::cout << "Enter name: ";
+            std::getline(std::cin, name);
+            student = fetchStudentByName(name);
+            break;
+        }
+        case 2:
+        {
+            int id;
+            std::cout << "Enter ID: ";
+            std::cin >> id;
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            student = fetchStudentById(id);
+            break;
+        }
+        case 3:
+            break;
+        default:
+            std::cout << "Invalid choice.\n";
+            waitForEnter();
+        }
+        if (student != nullptr)
+        {
+            printStudentTable({ *student });
+            std::cout << "Average Score: " << getAverageScore(student) << std::endl;
+            waitForEnter();
+        }
+    }
+}
+
+void appendVarint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(const std::string& in, size_t& pos, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7)
+    {
+        unsigned char byte = static_cast<unsigned char>(in[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool readVarint(std::istream& in, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        int byte = in.get();
+        if (byte == std::char_traits<char>::eof())
+        {
+            return false;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t zigzagEncode(uint32_t value)
+{
+    return (value << 1) ^ (0u - (value >> 31));
+}
+
+uint32_t zigzagEncode(int value)
+{
+    return zigzagEncode(static_cast<uint32_t>(value));
+}
+
+int zigzagDecode(uint32_t value)
+{
+    return static_cast<int>((value >> 1) ^ (0u - (value & 1)));
+}
+
+std::string compressBlock(const std::string& in)
+{
+    std::string out;
+    std::vector<int> table(1 << 12, -1);
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + 4 <= in.size())
+    {
+        uint32_t sequence;
+        std::memcpy(&sequence, in.data() + pos, 4);
+        size_t slot = (sequence * 2654435761u) >> 20;
+        int candidate = table[slot];
+        table[slot] = static_cast<int>(pos);
+
+        if (candidate >= 0 && std::memcmp(in.data() + candidate, in.data() + pos, 4) == 0)
+        {
+            size_t length = 4;
+            while (pos + length < in.size() && length < archiveMaxMatchLength &&
+                in[candidate + length] == in[pos + length])
+            {
+                ++length;
+            }
+            appendVarint(out, pos - anchor);
+            out.append(in, anchor, pos - anchor);
+            appendVarint(out, length);
+            appendVarint(out, pos - candidate);
+            pos += length;
+            anchor = pos;
+        }
+        else
+        {
+            ++pos;
+        }
+    }
+    appendVarint(out, in.size() - anchor);
+    out.append(in, anchor, std::string::npos);
+    return out;
+}
+
+bool decompressBlock(const std::string& in, std::string& out, size_t rawSize)
+{
+    out.clear();
+    if (rawSize > in.size() * archiveMaxExpansion)
+    {
+        return false;
+    }
+    out.reserve(rawSize);
+    size_t pos = 0;
+    while (pos < in.size())
+    {
+        uint64_t literalLength;
+        if (!readVarint(in, pos, literalLength) || literalLength > in.size() - pos ||
+            out.size() + literalLength > rawSize)
+        {
+            return false;
+        }
+        out.append(in, pos, static_cast<size_t>(literalLength));
+        pos += static_cast<size_t>(literalLength);
+        if (pos == in.size())
+        {
+            break;
+        }
+
+        uint64_t matchLength, offset;
+        if (!readVarint(in, pos, matchLength) || !readVarint(in, pos, offset) ||
+            offset == 0 || offset > out.size() || out.size() + matchLength > rawSize)
+        {
+            return false;
+        }
+        size_t from = out.size() - static_cast<size_t>(offset);
+        for (size_t i = 0; i < matchLength; ++i)
+        {
+            out.push_back(out[from + i]);
+        }
+    }
+    return out.size() == rawSize;
+}
+
+std::string encodeArchiveBlock(const Student* records, size_t count,
+    const std::unordered_map<std::string, uint32_t>& departmentCodes,
+    const std::unordered_map<std::string, uint32_t>& majorCodes)
+{
+    std::string raw;
+    appendVarint(raw, count);
+
+    int64_t previousId = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i == 0)
+        {
+            appendVarint(raw, zigzagEncode(records[i].id));
+        }
+        else
+        {
+            appendVarint(raw, static_cast<uint64_t>(records[i].id - previousId));
+        }
+        previousId = records[i].id;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        appendVarint(raw, records[i].name.size());
+        raw += records[i].name;
+        appendVarint(raw, departmentCodes.at(records[i].department));
+        appendVarint(raw, majorCodes.at(records[i].major));
+    }
+
+    uint32_t widest = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int score : records[i].scores)
+        {
+            widest |= zigzagEncode(score);
+        }
+    }
+    int bitWidth = 0;
+    while (bitWidth < 32 && (widest >> bitWidth) != 0)
+    {
+        ++bitWidth;
+    }
+    raw.push_back(static_cast<char>(bitWidth));
+
+    uint64_t bitBuffer = 0;
+    int bitCount = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int score : records[i].scores)
+        {
+            bitBuffer |= static_cast<uint64_t>(zigzagEncode(score)) << bitCount;
+            bitCount += bitWidth;
+            while (bitCount >= 8)
+            {
+                raw.push_back(static_cast<char>(bitBuffer & 0xff));
+                bitBuffer >>= 8;
+                bitCount -= 8;
+            }
+        }
+    }
+    if (bitCount > 0)
+    {
+        raw.push_back(static_cast<char>(bitBuffer & 0xff));
+    }
+    return raw;
+}
+
+bool decodeArchiveBlock(const std::string& raw, const std::vector<std::string>& departments,
+    const std::vector<std::string>& majors, std::vector<Student>& records)
+{
+    size_t pos = 0;
+    uint64_t count;
+    if (!readVarint(raw, pos, count) || count > raw.size())
+    {
+        return false;
+    }
+
+    size_t first = records.size();
+    records.resize(first + static_cast<size_t>(count));
+    int64_t previousId = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t value;
+        if (!readVarint(raw, pos, value))
+        {
+            return false;
+        }
+        previousId = i == 0 ? zigzagDecode(static_cast<uint32_t>(value))
+            : previousId + static_cast<int64_t>(value);
+        records[first + i].id = static_cast<int>(previousId);
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        Student& student = records[first + i];
+        uint64_t length, department, major;
+        if (!readVarint(raw, pos, length) || length > raw.size() - pos)
+        {
+            return false;
+        }
+        student.name = raw.substr(pos, static_cast<size_t>(length));
+        pos += static_cast<size_t>(length);
+        if (!readVarint(raw, pos, department) || department >= departments.size() ||
+            !readVarint(raw, pos, major) || major >= majors.size())
+        {
+            return false;
+        }
+        student.department = departments[static_cast<size_t>(department)];
+        student.major = majors[static_cast<size_t>(major)];
+    }
+
+    if (pos >= raw.size())
+    {
+        return false;
+    }
+    int bitWidth = raw[pos++];
+    if (bitWidth < 0 || bitWidth > 32 ||
+        (count * 5 * bitWidth + 7) / 8 > raw.size() - pos)
+    {
+        return false;
+    }
+
+    uint64_t bitBuffer = 0;
+    int bitCount = 0;
+    uint64_t mask = (uint64_t(1) << bitWidth) - 1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Student& student = records[first + i];
+        student.scores.resize(5);
+        for (int& score : student.scores)
+        {
+            while (bitCount < bitWidth)
+            {
+                bitBuffer |= static_cast<uint64_t>(static_cast<unsigned char>(raw[pos++])) << bitCount;
+                bitCount += 8;
+            }
+            score = zigzagDecode(static_cast<uint32_t>(bitBuffer & mask));
+            bitBuffer >>= bitWidth;
+            bitCount -= bitWidth;
+        }
+        student.calculateTotalScore();
+    }
+    return true;
+}
+
+bool decodeArchiveRecord(const std::string& raw, const std::vector<std::string>& departments,
+    const std::vector<std::string>& majors, int id, Student& student, bool& found)
+{
+    size_t pos = 0;
+    uint64_t count;
+    if (!readVarint(raw, pos, count) || count > raw.size())
+    {
+        return false;
+    }
+
+    found = false;
+    size_t index = 0;
+    int64_t previousId = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t value;
+        if (!readVarint(raw, pos, value))
+        {
+            return false;
+        }
+        previousId = i == 0 ? zigzagDecode(static_cast<uint32_t>(value))
+            : previousId + static_cast<int64_t>(value);
+        if (!found && previousId == id)
+        {
+            found = true;
+            index = i;
+        }
+    }
+    if (!found)
+    {
+        return true;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t length, department, major;
+        if (!readVarint(raw, pos, length) || length > raw.size() - pos)
+        {
+            return false;
+        }
+        size_t name = pos;
+        pos += static_cast<size_t>(length);
+        if (!readVarint(raw, pos, department) || department >= departments.size() ||
+            !readVarint(raw, pos, major) || major >= majors.size())
+        {
+            return false;
+        }
+        if (i == index)
+        {
+            student.name = raw.substr(name, static_cast<size_t>(length));
+            student.id = id;
+            student.department = departments[static_cast<size_t>(department)];
+            student.major = majors[static_cast<size_t>(major)];
+        }
+    }
+
+    if (pos >= raw.size())
+    {
+        return false;
+    }
+    int bitWidth = raw[pos++];
+    if (bitWidth < 0 || bitWidth > 32 ||
+        (count * 5 * bitWidth + 7) / 8 > raw.size() - pos)
+    {
+        return false;
+    }
+
+    student.scores.resize(5);
+    for (size_t i = 0; i < 5; ++i)
+    {
+        uint64_t first = (index * 5 + i) * bitWidth;
+        uint32_t value = 0;
+        for (int bit = 0; bit < bitWidth; ++bit)
+        {
+            uint64_t at = first + bit;
+            value |= static_cast<uint32_t>((static_cast<unsigned char>(raw[pos + at / 8]) >> (at % 8)) & 1) << bit;
+        }
+        student.scores[i] = zigzagDecode(value);
+    }
+    student.calculateTotalScore();
+    return true;
+}
+
+bool readArchiveHeader(std::istream& in, ArchiveHeader& header)
+{
+    char magic[4];
+    if (!in.read(magic, 4) || std::memcmp(magic, archiveMagic, 4) != 0 ||
+        in.get() != archiveVersion)
+    {
+        return false;
+    }
+
+    for (auto* dictionary : { &header.departments, &header.majors })
+    {
+        uint64_t count;
+        if (!readVarint(in, count))
+        {
+            return false;
+        }
+        dictionary->clear();
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            uint64_t length;
+            if (!readVarint(in, length) || length > 4096)
+            {
+                return false;
+            }
+            std::string entry(static_cast<size_t>(length), '\0');
+            if (!in.read(&entry[0], entry.size()))
+            {
+                return false;
+            }
+            dictionary->push_back(std::move(entry));
+        }
+    }
+
+    uint64_t blockCount;
+    if (!readVarint(in, blockCount))
+    {
+        return false;
+    }
+    header.blocks.clear();
+    for (uint64_t i = 0; i < blockCount; ++i)
+    {
+        ArchiveBlockInfo block;
+        uint64_t firstId;
+        if (!readVarint(in, firstId) || !readVarint(in, block.offset) ||
+            !readVarint(in, block.compressedSize) || !readVarint(in, block.rawSize))
+        {
+            return false;
+        }
+        block.firstId = zigzagDecode(static_cast<uint32_t>(firstId));
+        header.blocks.push_back(block);
+    }
+    header.dataStart = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    in.seekg(header.dataStart);
+    if (header.dataStart < 0 || end < header.dataStart)
+    {
+        return false;
+    }
+
+    uint64_t dataSize = static_cast<uint64_t>(end - header.dataStart);
+    for (const auto& block : header.blocks)
+    {
+        if (block.offset > dataSize || block.compressedSize > dataSize - block.offset ||
+            block.rawSize > block.compressedSize * archiveMaxExpansion)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readArchiveBlock(std::istream& in, const ArchiveHeader& header, size_t blockIndex,
+    std::vector<Student>& records)
+{
+    const ArchiveBlockInfo& block = header.blocks[blockIndex];
+    std::string compressed(static_cast<size_t>(block.compressedSize), '\0');
+    in.clear();
+    in.seekg(header.dataStart + static_cast<std::streamoff>(block.offset));
+    if (!in.read(&compressed[0], compressed.size()))
+    {
+        return false;
+    }
+
+    std::string raw;
+    return decompressBlock(compressed, raw, static_cast<size_t>(block.rawSize)) &&
+        decodeArchiveBlock(raw, header.departments, header.majors, records);
+}
+
+void saveStudentsToArchive(const std::string& filename)
+{
+    std::vector<Student> sorted(students);
+    std::sort(sorted.begin(), sorted.end(),
+        [](const Student& a, const Student& b)
+        { return a.id < b.id; });
+
+    std::string dictionaries;
+    std::unordered_map<std::string, uint32_t> departmentCodes, majorCodes;
+    for (auto* codes : { &departmentCodes, &majorCodes })
+    {
+        std::vector<const std::string*> entries;
+        for (const auto& student : sorted)
+        {
+            const std::string& value = codes == &departmentCodes ? student.department : student.major;
+            if (codes->emplace(value, static_cast<uint32_t>(entries.size())).second)
+            {
+                entries.push_back(&value);
+            }
+        }
+        appendVarint(dictionaries, entries.size());
+        for (const auto* entry : entries)
+        {
+            appendVarint(dictionaries, entry->size());
+            dictionaries += *entry;
+        }
+    }
+
+    size_t blockCount = (sorted.size() + archiveBlockRecords - 1) / archiveBlockRecords;
+    std::vector<std::string> compressedBlocks(blockCount);
+    std::vector<size_t> rawSizes(blockCount);
+    runInParallel(blockCount, [&](size_t i)
+        {
+            size_t first = i * archiveBlockRecords;
+            size_t count = std::min(archiveBlockRecords, sorted.size() - first);
+            std::string raw = encodeArchiveBlock(&sorted[first], count, departmentCodes, majorCodes);
+            rawSizes[i] = raw.size();
+            compressedBlocks[i] = compressBlock(raw);
+        });
+
+    std::string directory;
+    appendVarint(directory, blockCount);
+    uint64_t offset = 0;
+    for (size_t i = 0; i < blockCount; ++i)
+    {
+        appendVarint(directory, zigzagEncode(sorted[i * archiveBlockRecords].id));
+        appendVarint(directory, offset);
+        appendVarint(directory, compressedBlocks[i].size());
+        appendVarint(directory, rawSizes[i]);
+        offset += compressedBlocks[i].size();
+    }
+
+    std::ofstream outFile(filename, std::ios::binary);
+    if (!outFile)
+    {
+        std::cerr << "Error: Unable to open file " << filename << " for writing.\n";
+        waitForEnter();
+        return;
+    }
+    outFile.write(archiveMagic, 4);
+    outFile.put(archiveVersion);
+    outFile << dictionaries << directory;
+    for (const auto& block : compressedBlocks)
+    {
+        outFile << block;
+    }
+    outFile.close();
+    if (!outFile)
+    {
+        std::cerr << "Error: Unable to write file " << filename << ".\n";
+        waitForEnter();
+        return;
+    }
+
+    uint64_t archiveSize = 5 + dictionaries.size() + directory.size() + offset;
+    uint64_t textSize = 0;
+    for (const auto& student : students)
+    {
+        textSize += getStudentRecordTextSize(student);
+    }
+
+    std::cout << "Archived " << sorted.size() << " records in " << blockCount << " blocks to "
+        << filename << ".\n";
+    std::streamsize precision = std::cout.precision();
+    std::cout << "Text size: " << textSize << " bytes, archive size: " << archiveSize
+        << " bytes, compression ratio: " << std::fixed << std::setprecision(2)
+        << static_cast<double>(textSize) / archiveSize << ":1\n"
+        << std::defaultfloat << std::setprecision(precision);
+    waitForEnter();
+}
+
+bool loadStudentsFromArchive(const std::string& filename)
+{
+    std::ifstream inFile(filename, std::ios::binary);
+    ArchiveHeader header;
+    if (!inFile || !readArchiveHeader(inFile, header))
+    {
+        std::cerr << "Error: Unable to read archive " << filename << ".\n";
+        waitForEnter();
+        return false;
+    }
+
+    std::vector<std::string> compressedBlocks(header.blocks.size());
+    for (size_t i = 0; i < header.blocks.size(); ++i)
+    {
+        compressedBlocks[i].resize(static_cast<size_t>(header.blocks[i].compressedSize));
+        inFile.seekg(header.dataStart + static_cast<std::streamoff>(header.blocks[i].offset));
+        if (!inFile.read(&compressedBlocks[i][0], compressedBlocks[i].size()))
+        {
+            std::cerr << "Error: Archive " << filename << " is truncated.\n";
+            waitForEnter();
+            return false;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::vector<Student>> decodedBlocks(header.blocks.size());
+    std::vector<char> failed(header.blocks.size(), 0);
+    runInParallel(header.blocks.size(), [&](size_t i)
+        {
+            std::string raw;
+            failed[i] = !decompressBlock(compressedBlocks[i], raw,
+                static_cast<size_t>(header.blocks[i].rawSize)) ||
+                !decodeArchiveBlock(raw, header.departments, header.majors, decodedBlocks[i]);
+        });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (std::find(failed.begin(), failed.end(), 1) != failed.end())
+    {
+        std::cerr << "Error: Archive " << filename << " is corrupt.\n";
+        waitForEnter();
+        return false;
+    }
+
+    students.clear();
+    uint64_t rawBytes = 0;
+    for (size_t i = 0; i < decodedBlocks.size(); ++i)
+    {
+        students.insert(students.end(), decodedBlocks[i].begin(), decodedBlocks[i].end());
+        rawBytes += header.blocks[i].rawSize;
+    }
+    removeDuplicateIds(students);
+    partitionStudentsIntoShards();
+
+    std::streamsize precision = std::cout.precision();
+    std::cout << "Data loaded from " << filename << ".\n";
+    std::cout << "Decoded " << students.size() << " records in " << std::fixed << std::setprecision(2)
+        << seconds * 1000 << " ms (" << (seconds > 0 ? rawBytes / seconds / (1024 * 1024) : 0.0)
+        << " MB/s, " << (seconds > 0 ? students.size() / seconds : 0.0) << " records/s).\n"
+        << std::defaultfloat << std::setprecision(precision);
+    waitForEnter();
+    return true;
+}
+
+bool readArchivedStudent(const std::string& filename, int id, Student& result)
+{
+    std::ifstream inFile(filename, std::ios::binary);
+    ArchiveHeader header;
+    if (!inFile || !readArchiveHeader(inFile, header))
+    {
+        std::cerr << "Error: Unable to read archive " << filename << ".\n";
+        return false;
+    }
+
+    auto block = std::upper_bound(header.blocks.begin(), header.blocks.end(), id,
+        [](int value, const ArchiveBlockInfo& b)
+        { return value < b.firstId; });
+    if (block != header.blocks.begin())
+    {
+        std::vector<Student> records;
+        if (!readArchiveBlock(inFile, header, (block - header.blocks.begin()) - 1, records))
+        {
+            std::cerr << "Error: Archive " << filename << " is corrupt.\n";
+            return false;
+        }
+        for (const auto& student : records)
+        {
+            if (student.id == id)
+            {
+                result = student;
+                return true;
+            }
+        }
+    }
+
+    std::cerr << "Error: Student with ID " << id << " not found in " << filename << ".\n";
+    return false;
+}
+
+bool openSortedRoster(const std::string& filename, const std::string& runPrefix,
+    SortedRosterReader& reader)
+{
+    std::ifstream inFile(filename);
+    if (!inFile)
+    {
+        std::cerr << "Error: Unable to open file " << filename << " for reading.\n";
+        return false;
+    }
+
+    auto byId = [](const Student& a, const Student& b)
+    { return a.id < b.id; };
+
+    std::vector<Student> chunk;
+    Student student;
+    bool more = true;
+    while (more)
+    {
+        chunk.clear();
+        while (chunk.size() < diffRunRecords && (more = readStudentRecord(inFile, student)))
+        {
+            chunk.push_back(student);
+        }
+        std::sort(chunk.begin(), chunk.end(), byId);
+
+        if (!more && reader.runFiles.empty())
+        {
+            reader.memoryRun.swap(chunk);
+            break;
+        }
+        if (chunk.empty())
+        {
+            break;
+        }
+
+        std::string runFile = runPrefix + std::to_string(reader.runFiles.size());
+        std::ofstream runOut(runFile);
+        writeStudentRecords(runOut, chunk);
+        reader.runFiles.push_back(runFile);
+        if (!runOut)
+        {
+            std::cerr << "Error: Unable to write temporary file " << runFile << ".\n";
+            closeSortedRoster(reader);
+            return false;
+        }
+    }
+
+    reader.heads.resize(reader.runFiles.size());
+    for (size_t i = 0; i < reader.runFiles.size(); ++i)
+    {
+        reader.runs.emplace_back(new std::ifstream(reader.runFiles[i]));
+        if (readStudentRecord(*reader.runs[i], reader.heads[i]))
+        {
+            reader.heap.push({ reader.heads[i].id, i });
+        }
+    }
+    return true;
+}
+
+bool nextSortedStudent(SortedRosterReader& reader, Student& student)
+{
+    if (reader.runFiles.empty())
+    {
+        if (reader.memoryPos >= reader.memoryRun.size())
+        {
+            return false;
+        }
+        student = std::move(reader.memoryRun[reader.memoryPos++]);
+        return true;
+    }
+
+    if (reader.heap.empty())
+    {
+        return false;
+    }
+    size_t run = reader.heap.top().second;
+    reader.heap.pop();
+    student = std::move(reader.heads[run]);
+    if (readStudentRecord(*reader.runs[run], reader.heads[run]))
+    {
+        reader.heap.push({ reader.heads[run].id, run });
+    }
+    return true;
+}
+
+void closeSortedRoster(SortedRosterReader& reader)
+{
+    reader.runs.clear();
+    for (const auto& runFile : reader.runFiles)
+    {
+        std::remove(runFile.c_str());
+    }
+    reader.runFiles.clear();
+    reader.memoryRun.clear();
+}
+
+bool isSameStudentRecord(const Student& a, const Student& b)
+{
+    return a.name == b.name && a.department == b.department &&
+        a.major == b.major && a.scores == b.scores;
+}
+
+bool diffRosterFiles(const std::string& baseFilename, const std::string& otherFilename,
+    const std::string& diffFilename, RosterDiffSummary& summary)
+{
+    std::ofstream diffOut(diffFilename);
+    if (!diffOut)
+    {
+        std::cerr << "Error: Unable to open file " << diffFilename << " for writing.\n";
+        return false;
+    }
+
+    SortedRosterReader base, other;
+    if (!openSortedRoster(baseFilename, diffFilename + ".base.run", base))
+    {
+        return false;
+    }
+    if (!openSortedRoster(otherFilename, diffFilename + ".other.run", other))
+    {
+        closeSortedRoster(base);
+        return false;
+    }
+
+    Student baseStudent, otherStudent;
+    bool hasBase = nextSortedStudent(base, baseStudent);
+    bool hasOther = nextSortedStudent(other, otherStudent);
+    while (hasBase || hasOther)
+    {
+        if (hasBase && (!hasOther || baseStudent.id < otherStudent.id))
+        {
+            diffOut << "- ";
+            writeStudentRecord(diffOut, baseStudent);
+            ++summary.removed;
+            hasBase = nextSortedStudent(base, baseStudent);
+        }
+        else if (hasOther && (!hasBase || otherStudent.id < baseStudent.id))
+        {
+            diffOut << "+ ";
+            writeStudentRecord(diffOut, otherStudent);
+            ++summary.added;
+            hasOther = nextSortedStudent(other, otherStudent);
+        }
+        else
+        {
+            if (!isSameStudentRecord(baseStudent, otherStudent))
+            {
+                diffOut << "~ ";
+                writeStudentRecord(diffOut, otherStudent);
+                ++summary.changed;
+            }
+            hasBase = nextSortedStudent(base, baseStudent);
+            hasOther = nextSortedStudent(other, otherStudent);
+        }
+    }
+
+    closeSortedRoster(base);
+    closeSortedRoster(other);
+    if (!diffOut)
+    {
+        std::cerr << "Error: Unable to write file " << diffFilename << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool applyRosterDiff(const std::string& diffFilename, RosterDiffSummary& summary)
+{
+    std::ifstream diffIn(diffFilename);
+    if (!diffIn)
+    {
+        std::cerr << "Error: Unable to open file " << diffFilename << " for reading.\n";
+        return false;
+    }
+
+    std::unordered_map<int, size_t> idIndex;
+    for (size_t i = 0; i < students.size(); ++i)
+    {
+        idIndex[students[i].id] = i;
+    }
+
+    std::vector<char> removed(students.size(), 0);
+    std::string line;
+    Student student;
+    while (std::getline(diffIn, line))
+    {
+        std::istringstream record(line.size() > 2 ? line.substr(2) : std::string());
+        if (line.empty() || !readStudentRecord(record, student))
+        {
+            continue;
+        }
+
+        auto it = idIndex.find(student.id);
+        switch (line[0])
+        {
+        case '+':
+        case '~':
+            if (it != idIndex.end())
+            {
+                students[it->second] = student;
+                removed[it->second] = 0;
+                ++summary.changed;
+            }
+            else
+            {
+                idIndex[student.id] = students.size();
+                students.push_back(student);
+                removed.push_back(0);
+                ++summary.added;
+            }
+            break;
+        case '-':
+            if (it != idIndex.end() && !removed[it->second])
+            {
+                removed[it->second] = 1;
+                ++summary.removed;
+            }
+            break;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < students.size(); ++i)
+    {
+        if (!removed[i])
+        {
+            if (kept != i)
+            {
+                students[kept] = std::move(students[i]);
+            }
+            ++kept;
+        }
+    }
+    students.resize(kept);
+    partitionStudentsIntoShards();
+    return true;
+}
+
+void startBackgroundPersistence(const std::string& filename)
+{
+    persistence.filename = filename;
+    persistence.mirror = students;
+    persistence.mirrorFingerprint = fingerprintRoster(students);
+    persistence.stopping = false;
+    persistence.worker = std::thread(runPersistenceWorker);
+}
+
+void queueStudentChange(StudentChange* change)
+{
+    takeUnsavedGradeHistory(change->history);
+    change->next = persistence.pending.load(std::memory_order_relaxed);
+    while (!persistence.pending.compare_exchange_weak(change->next, change,
+        std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    {
+        std::lock_guard<std::mutex> lock(persistence.wakeMutex);
+    }
+    persistence.wake.notify_one();
+}
+
+void queueStudentUpsert(const Student& student)
+{
+    StudentChange* change = new StudentChange;
+    change->kind = StudentChangeKind::Upsert;
+    change->student = student;
+    queueStudentChange(change);
+}
+
+void queueStudentRemovalById(int id)
+{
+    StudentChange* change = new StudentChange;
+    change->kind = StudentChangeKind::RemoveById;
+    change->student.id = id;
+    queueStudentChange(change);
+}
+
+void queueRosterSnapshot()
+{
+    StudentChange* change = new StudentChange;
+    change->kind = StudentChangeKind::ReplaceAll;
+    change->roster.reset(new std::vector<Student>(students));
+    queueStudentChange(change);
+}
+
+bool flushBackgroundPersistence()
+{
+    if (!persistence.worker.joinable())
+    {
+        return true;
+    }
+    StudentChange* change = new StudentChange;
+    change->kind = StudentChangeKind::Flush;
+    change->flushed.reset(new std::promise<bool>);
+    std::future<bool> flushed = change->flushed->get_future();
+    queueStudentChange(change);
+    return flushed.get();
+}
+
+bool stopBackgroundPersistence()
+{
+    if (!persistence.worker.joinable())
+    {
+        return true;
+    }
+    bool saved = flushBackgroundPersistence();
+    persistence.stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(persistence.wakeMutex);
+    }
+    persistence.wake.notify_one();
+    persistence.worker.join();
+    return saved;
+}
+
+void runPersistenceWorker()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(persistence.wakeMutex);
+            persistence.wake.wait(lock, []()
+                { return persistence.pending.load() != nullptr || persistence.stopping.load(); });
+        }
+
+        StudentChange* batch = persistence.pending.exchange(nullptr, std::memory_order_acquire);
+        if (batch == nullptr && persistence.stopping)
+        {
+            return;
+        }
+
+        StudentChange* ordered = nullptr;
+        while (batch != nullptr)
+        {
+            StudentChange* next = batch->next;
+            batch->next = ordered;
+            ordered = batch;
+            batch = next;
+        }
+
+        bool dirty = false;
+        bool historyDirty = false;
+        auto commit = [&dirty, &historyDirty]()
+        {
+            if (dirty)
+            {
+                std::ofstream outFile(persistence.filename);
+                writeStudentRecords(outFile, persistence.mirror);
+                persistence.writeFailed = !outFile;
+                dirty = false;
+            }
+            if (historyDirty)
+            {
+                persistence.historyFile.flush();
+                if (!persistence.historyFile)
+                {
+                    persistence.historyWriteFailed = true;
+                    persistence.historyFile.close();
+                    persistence.historyFile.clear();
+                }
+                historyDirty = false;
+            }
+        };
+        auto appendHistory = [&historyDirty](const std::string& bytes)
+        {
+            if (!persistence.historyFile.is_open())
+            {
+                persistence.historyFile.open(gradeHistory.filename, std::ios::binary | std::ios::app);
+            }
+            persistence.historyFile << bytes;
+            historyDirty = true;
+        };
+
+        while (ordered != nullptr)
+        {
+            StudentChange* change = ordered;
+            ordered = change->next;
+            if (!change->history.empty())
+            {
+                appendHistory(change->history);
+            }
+            std::vector<Student>& mirror = persistence.mirror;
+            switch (change->kind)
+            {
+            case StudentChangeKind::Upsert:
+            {
+                auto it = std::find_if(mirror.begin(), mirror.end(),
+                    [change](const Student& s)
+                    { return s.id == change->student.id; });
+                persistence.mirrorFingerprint.add(hashStudentRecord(change->student));
+                if (it != mirror.end())
+                {
+                    persistence.mirrorFingerprint.remove(hashStudentRecord(*it));
+                    *it = std::move(change->student);
+                }
+                else
+                {
+                    mirror.push_back(std::move(change->student));
+                }
+                dirty = true;
+                break;
+            }
+            case StudentChangeKind::RemoveById:
+            {
+                auto it = std::find_if(mirror.begin(), mirror.end(),
+                    [change](const Student& s)
+                    { return s.id == change->student.id; });
+                if (it != mirror.end())
+                {
+                    persistence.mirrorFingerprint.remove(hashStudentRecord(*it));
+                    mirror.erase(it);
+                    dirty = true;
+                }
+                break;
+            }
+            case StudentChangeKind::ReplaceAll:
+                mirror.swap(*change->roster);
+                persistence.mirrorFingerprint = fingerprintRoster(mirror);
+                dirty = true;
+                break;
+            case StudentChangeKind::Checkpoint:
+            {
+                if (!(persistence.mirrorFingerprint == change->checkpoint->fingerprint))
+                {
+                    persistence.mirrorDiverged = true;
+                    break;
+                }
+                buildGradeCheckpoint(mirror, *change->checkpoint);
+                std::string record;
+                appendGradeCheckpointRecord(record, *change->checkpoint);
+                appendHistory(record);
+                std::lock_guard<std::mutex> lock(gradeHistory.checkpointMutex);
+                gradeHistory.checkpoints.push_back(std::move(*change->checkpoint));
+                break;
+            }
+            case StudentChangeKind::Flush:
+                commit();
+                change->flushed->set_value(!persistence.writeFailed);
+                break;
+            }
+            delete change;
+        }
+        commit();
+    }
+}
+
+void checkBackgroundPersistence()
+{
+    if (persistence.mirrorDiverged.exchange(false))
+    {
+        std::cerr << "Error: The roster being saved no longer matches the roster in memory. Saving it again.\n";
+        waitForEnter();
+        queueRosterSnapshot();
+        recordRosterReplaced();
+    }
+    if (persistence.historyWriteFailed.exchange(false))
+    {
+        std::cerr << "Error: Unable to write file " << gradeHistory.filename << ".\n";
+        waitForEnter();
+    }
+}
+
+uint64_t hashStudentRecord(const std::string& name, int id, const std::string& department,
+    const std::string& major, const std::vector<int>& scores)
+{
+    uint64_t hash = hashStudentName(name.data(), name.size());
+    for (const std::string* value : { &department, &major })
+    {
+        hash = (hash ^ hashStudentName(value->data(), value->size())) * 1099511628211ull;
+    }
+    hash = (hash ^ zigzagEncode(id)) * 1099511628211ull;
+    for (int score : scores)
+    {
+        hash = (hash ^ zigzagEncode(score)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t hashStudentRecord(const Student& student)
+{
+    return hashStudentRecord(student.name, student.id, student.department, student.major, student.scores);
+}
+
+RosterFingerprint fingerprintRoster(const std::vector<Student>& roster)
+{
+    RosterFingerprint fingerprint;
+    for (const auto& student : roster)
+    {
+        fingerprint.add(hashStudentRecord(student));
+    }
+    return fingerprint;
+}
+
+uint32_t internHistoryString(const std::string& value)
+{
+    auto inserted = gradeHistory.codes.emplace(value, static_cast<uint32_t>(gradeHistory.codes.size()));
+    if (inserted.second)
+    {
+        gradeHistory.strings.push_back(value);
+    }
+    return inserted.first->second;
+}
+
+void requestGradeCheckpoint(bool replacesRoster)
+{
+    StudentChange* change = new StudentChange;
+    change->kind = StudentChangeKind::Checkpoint;
+    change->checkpoint.reset(new GradeCheckpoint);
+    change->checkpoint->time = std::max(gradeHistory.lastTime, std::time(nullptr));
+    change->checkpoint->logOffset = gradeHistory.log.size();
+    change->checkpoint->replacesRoster = replacesRoster;
+    change->checkpoint->fingerprint = gradeHistory.fingerprint;
+    gradeHistory.lastTime = change->checkpoint->time;
+    gradeHistory.changesSinceCheckpoint = 0;
+    queueStudentChange(change);
+}
+
+void buildGradeCheckpoint(const std::vector<Student>& roster, GradeCheckpoint& checkpoint)
+{
+    std::vector<Student> sorted(roster);
+    std::sort(sorted.begin(), sorted.end(),
+        [](const Student& a, const Student& b)
+        { return a.id < b.id; });
+
+    std::unordered_map<std::string, uint32_t> codes;
+    for (const auto& student : sorted)
+    {
+        for (const std::string* value : { &student.department, &student.major })
+        {
+            if (codes.emplace(*value, static_cast<uint32_t>(checkpoint.strings.size())).second)
+            {
+                checkpoint.strings.push_back(*value);
+            }
+        }
+    }
+
+    std::string raw = encodeArchiveBlock(sorted.data(), sorted.size(), codes, codes);
+    checkpoint.compressed = compressBlock(raw);
+    checkpoint.rawSize = raw.size();
+}
+
+void appendGradeChangeHeader(GradeChangeKind kind, uint32_t changedFields, int id)
+{
+    if (gradeHistory.changesSinceCheckpoint >= gradeCheckpointInterval)
+    {
+        requestGradeCheckpoint(false);
+    }
+    ++gradeHistory.changesSinceCheckpoint;
+
+    std::time_t now = std::max(gradeHistory.lastTime, std::time(nullptr));
+    appendVarint(gradeHistory.log, static_cast<uint64_t>(now - gradeHistory.lastTime));
+    gradeHistory.lastTime = now;
+    appendVarint(gradeHistory.log, (static_cast<uint64_t>(changedFields) << 2) | static_cast<uint64_t>(kind));
+    appendVarint(gradeHistory.log, zigzagEncode(id));
+}
+
+bool readGradeHistory(const std::string& contents)
+{
+    if (contents.size() < 5 || std::memcmp(contents.data(), gradeHistoryMagic, 4) != 0 ||
+        contents[4] != gradeHistoryVersion)
+    {
+        return false;
+    }
+
+    size_t pos = 5;
+    while (pos < contents.size())
+    {
+        char type = contents[pos++];
+        uint64_t length;
+        if (type == 'S' || type == 'L')
+        {
+            if (!readVarint(contents, pos, length) || length > contents.size() - pos)
+            {
+                return false;
+            }
+            if (type == 'S')
+            {
+                internHistoryString(contents.substr(pos, static_cast<size_t>(length)));
+            }
+            else
+            {
+                gradeHistory.log.append(contents, pos, static_cast<size_t>(length));
+            }
+            pos += static_cast<size_t>(length);
+        }
+        else if (type == 'C')
+        {
+            GradeCheckpoint checkpoint;
+            uint64_t time, logOffset, stringCount, rawSize;
+            if (!readVarint(contents, pos, time) || !readVarint(contents, pos, logOffset) ||
+                pos >= contents.size())
+            {
+                return false;
+            }
+            checkpoint.time = static_cast<std::time_t>(time);
+            checkpoint.logOffset = static_cast<size_t>(logOffset);
+            checkpoint.replacesRoster = contents[pos++] != 0;
+            if (!readVarint(contents, pos, stringCount) || stringCount > contents.size() - pos)
+            {
+                return false;
+            }
+            for (uint64_t i = 0; i < stringCount; ++i)
+            {
+                if (!readVarint(contents, pos, length) || length > contents.size() - pos)
+                {
+                    return false;
+                }
+                checkpoint.strings.push_back(contents.substr(pos, static_cast<size_t>(length)));
+                pos += static_cast<size_t>(length);
+            }
+            if (!readVarint(contents, pos, rawSize) || !readVarint(contents, pos, length) ||
+                length > contents.size() - pos)
+            {
+                return false;
+            }
+            checkpoint.rawSize = static_cast<size_t>(rawSize);
+            checkpoint.compressed = contents.substr(pos, static_cast<size_t>(length));
+            pos += static_cast<size_t>(length);
+
+            const std::vector<GradeCheckpoint>& checkpoints = gradeHistory.checkpoints;
+            if (!checkpoints.empty() && (checkpoint.time < checkpoints.back().time ||
+                checkpoint.logOffset < checkpoints.back().logOffset))
+            {
+                return false;
+            }
+            gradeHistory.checkpoints.push_back(std::move(checkpoint));
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool trimGradeHistory()
+{
+    std::vector<GradeCheckpoint>& checkpoints = gradeHistory.checkpoints;
+    bool intact = true;
+    for (size_t i = 0; i < checkpoints.size(); ++i)
+    {
+        if (checkpoints[i].logOffset > gradeHistory.log.size())
+        {
+            checkpoints.resize(i);
+            return false;
+        }
+
+        size_t pos = checkpoints[i].logOffset;
+        std::time_t changeTime = checkpoints[i].time;
+        size_t end = i + 1 < checkpoints.size() ? checkpoints[i + 1].logOffset : gradeHistory.log.size();
+        GradeChange change;
+        while (pos < end)
+        {
+            size_t entry = pos;
+            if (!readGradeChange(gradeHistory.log, pos, changeTime, change) || pos > end)
+            {
+                gradeHistory.log.resize(entry);
+                checkpoints.resize(i + 1);
+                intact = false;
+                break;
+            }
+        }
+        gradeHistory.lastTime = changeTime;
+    }
+    return intact;
+}
+
+bool writeGradeHistory(const std::string& filename)
+{
+    std::string contents(gradeHistoryMagic, 4);
+    contents.push_back(gradeHistoryVersion);
+    gradeHistory.savedStringCount = 0;
+    gradeHistory.savedLogSize = 0;
+    takeUnsavedGradeHistory(contents);
+    for (const auto& checkpoint : gradeHistory.checkpoints)
+    {
+        appendGradeCheckpointRecord(contents, checkpoint);
+    }
+
+    std::ofstream outFile(filename, std::ios::binary | std::ios::trunc);
+    outFile << contents;
+    outFile.close();
+    return static_cast<bool>(outFile);
+}
+
+void appendGradeCheckpointRecord(std::string& out, const GradeCheckpoint& checkpoint)
+{
+    out.push_back('C');
+    appendVarint(out, static_cast<uint64_t>(checkpoint.time));
+    appendVarint(out, checkpoint.logOffset);
+    out.push_back(checkpoint.replacesRoster ? 1 : 0);
+    appendVarint(out, checkpoint.strings.size());
+    for (const auto& value : checkpoint.strings)
+    {
+        appendVarint(out, value.size());
+        out += value;
+    }
+    appendVarint(out, checkpoint.rawSize);
+    appendVarint(out, checkpoint.compressed.size());
+    out += checkpoint.compressed;
+}
+
+void takeUnsavedGradeHistory(std::string& out)
+{
+    for (size_t i = gradeHistory.savedStringCount; i < gradeHistory.strings.size(); ++i)
+    {
+        out.push_back('S');
+        appendVarint(out, gradeHistory.strings[i].size());
+        out += gradeHistory.strings[i];
+    }
+    gradeHistory.savedStringCount = gradeHistory.strings.size();
+
+    if (gradeHistory.log.size() > gradeHistory.savedLogSize)
+    {
+        out.push_back('L');
+        appendVarint(out, gradeHistory.log.size() - gradeHistory.savedLogSize);
+        out.append(gradeHistory.log, gradeHistory.savedLogSize, std::string::npos);
+        gradeHistory.savedLogSize = gradeHistory.log.size();
+    }
+}
+
+void startGradeHistory(const std::string& filename)
+{
+    gradeHistory.filename = filename;
+    std::ifstream inFile(filename, std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+    inFile.close();
+
+    bool intact = true;
+    {
+        std::lock_guard<std::mutex> lock(gradeHistory.checkpointMutex);
+        if (!contents.empty())
+        {
+            intact = readGradeHistory(contents);
+            intact = trimGradeHistory() && intact;
+        }
+        if (!intact)
+        {
+            std::cerr << "Error: Grade history in " << filename << " is damaged. Keeping the readable part.\n";
+        }
+        if ((contents.empty() || !intact) && !writeGradeHistory(filename))
+        {
+            std::cerr << "Error: Unable to write file " << filename << ".\n";
+        }
+    }
+    if (!intact)
+    {
+        waitForEnter();
+    }
+    gradeHistory.savedStringCount = gradeHistory.strings.size();
+    gradeHistory.savedLogSize = gradeHistory.log.size();
+
+    gradeHistory.fingerprint = fingerprintRoster(students);
+    requestGradeCheckpoint(true);
+}
+
+void recordStudentAdded(const Student& student)
+{
+    appendGradeChangeHeader(GradeChangeKind::Added, 0, student.id);
+    appendVarint(gradeHistory.log, student.name.size());
+    gradeHistory.log += student.name;
+    appendVarint(gradeHistory.log, internHistoryString(student.department));
+    appendVarint(gradeHistory.log, internHistoryString(student.major));
+    for (int score : student.scores)
+    {
+        appendVarint(gradeHistory.log, zigzagEncode(score));
+    }
+    gradeHistory.fingerprint.add(hashStudentRecord(student));
+}
+
+void recordStudentRemoved(const Student& student)
+{
+    appendGradeChangeHeader(GradeChangeKind::Removed, 0, student.id);
+    gradeHistory.fingerprint.remove(hashStudentRecord(student));
+}
+
+void recordStudentModified(const Student& student, const std::string& department,
+    const std::string& major, const std::vector<int>& scores)
+{
+    uint32_t changedFields = 0;
+    for (size_t i = 0; i < 5; ++i)
+    {
+        if (scores[i] != student.scores[i])
+        {
+            changedFields |= 1u << i;
+        }
+    }
+    if (department != student.department)
+    {
+        changedFields |= 1u << 5;
+    }
+    if (major != student.major)
+    {
+        changedFields |= 1u << 6;
+    }
+    if (changedFields == 0)
+    {
+        return;
+    }
+
+    appendGradeChangeHeader(GradeChangeKind::Modified, changedFields, student.id);
+    if (changedFields & (1u << 5))
+    {
+        appendVarint(gradeHistory.log, internHistoryString(department));
+    }
+    if (changedFields & (1u << 6))
+    {
+        appendVarint(gradeHistory.log, internHistoryString(major));
+    }
+    for (size_t i = 0; i < 5; ++i)
+    {
+        if (changedFields & (1u << i))
+        {
+            uint32_t delta = static_cast<uint32_t>(scores[i]) - static_cast<uint32_t>(student.scores[i]);
+            appendVarint(gradeHistory.log, zigzagEncode(delta));
+        }
+    }
+    gradeHistory.fingerprint.remove(hashStudentRecord(student));
+    gradeHistory.fingerprint.add(hashStudentRecord(student.name, student.id, department, major, scores));
+}
+
+void recordRosterReplaced()
+{
+    gradeHistory.fingerprint = fingerprintRoster(students);
+    requestGradeCheckpoint(true);
+}
+
+bool readGradeChange(const std::string& log, size_t& pos, std::time_t& time, GradeChange& change)
+{
+    uint64_t elapsed, header, id;
+    if (!readVarint(log, pos, elapsed) || !readVarint(log, pos, header) || !readVarint(log, pos, id))
+    {
+        return false;
+    }
+    time += static_cast<std::time_t>(elapsed);
+    change.time = time;
+    if ((header & 3) > static_cast<uint64_t>(GradeChangeKind::Modified) || (header >> 2) >= (1u << 7))
+    {
+        return false;
+    }
+    change.kind = static_cast<GradeChangeKind>(header & 3);
+    change.changedFields = static_cast<uint32_t>(header >> 2);
+    change.id = zigzagDecode(static_cast<uint32_t>(id));
+
+    uint64_t value;
+    if (change.kind == GradeChangeKind::Added)
+    {
+        uint64_t length, department, major;
+        if (!readVarint(log, pos, length) || length > log.size() - pos)
+        {
+            return false;
+        }
+        change.name = log.substr(pos, static_cast<size_t>(length));
+        pos += static_cast<size_t>(length);
+        if (!readVarint(log, pos, department) || !readVarint(log, pos, major))
+        {
+            return false;
+        }
+        if (department >= gradeHistory.strings.size() || major >= gradeHistory.strings.size())
+        {
+            return false;
+        }
+        change.department = static_cast<uint32_t>(department);
+        change.major = static_cast<uint32_t>(major);
+        for (int& score : change.scores)
+        {
+            if (!readVarint(log, pos, value))
+            {
+                return false;
+            }
+            score = zigzagDecode(static_cast<uint32_t>(value));
+        }
+    }
+    else if (change.kind == GradeChangeKind::Modified)
+    {
+        if (change.changedFields & (1u << 5))
+        {
+            if (!readVarint(log, pos, value) || value >= gradeHistory.strings.size())
+            {
+                return false;
+            }
+            change.department = static_cast<uint32_t>(value);
+        }
+        if (change.changedFields & (1u << 6))
+        {
+            if (!readVarint(log, pos, value) || value >= gradeHistory.strings.size())
+            {
+                return false;
+            }
+            change.major = static_cast<uint32_t>(value);
+        }
+        for (size_t i = 0; i < 5; ++i)
+        {
+            change.scores[i] = 0;
+            if (change.changedFields & (1u << i))
+            {
+                if (!readVarint(log, pos, value))
+                {
+                    return false;
+                }
+                change.scores[i] = zigzagDecode(static_cast<uint32_t>(value));
+            }
+        }
+    }
+    return true;
+}
+
+void applyGradeChange(const GradeChange& change, std::map<int, Student>& roster)
+{
+    const std::vector<std::string>& strings = gradeHistory.strings;
+    switch (change.kind)
+    {
+    case GradeChangeKind::Added:
+    {
+        Student& student = roster[change.id];
+        student.name = change.name;
+        student.id = change.id;
+        student.department = strings[change.department];
+        student.major = strings[change.major];
+        student.scores.assign(change.scores, change.scores + 5);
+        student.calculateTotalScore();
+        break;
+    }
+    case GradeChangeKind::Removed:
+        roster.erase(change.id);
+        break;
+    case GradeChangeKind::Modified:
+    {
+        auto it = roster.find(change.id);
+        if (it == roster.end())
+        {
+            break;
+        }
+        Student& student = it->second;
+        if (change.changedFields & (1u << 5))
+        {
+            student.department = strings[change.department];
+        }
+        if (change.changedFields & (1u << 6))
+        {
+            student.major = strings[change.major];
+        }
+        for (size_t i = 0; i < 5; ++i)
+        {
+            student.scores[i] = static_cast<int>(static_cast<uint32_t>(student.scores[i]) +
+                static_cast<uint32_t>(change.scores[i]));
+        }
+        student.calculateTotalScore();
+        break;
+    }
+    }
+}
+
+bool restoreGradeCheckpoint(const GradeCheckpoint& checkpoint, std::map<int, Student>& roster)
+{
+    std::string raw;
+    std::vector<Student> records;
+    if (!decompressBlock(checkpoint.compressed, raw, checkpoint.rawSize) ||
+        !decodeArchiveBlock(raw, checkpoint.strings, checkpoint.strings, records))
+    {
+        return false;
+    }
+    roster.clear();
+    for (auto& student : records)
+    {
+        int id = student.id;
+        roster[id] = std::move(student);
+    }
+    return true;
+}
+
+bool restoreGradeCheckpointRecord(const GradeCheckpoint& checkpoint, int id, std::map<int, Student>& roster)
+{
+    std::string raw;
+    Student student;
+    bool found;
+    if (!decompressBlock(checkpoint.compressed, raw, checkpoint.rawSize) ||
+        !decodeArchiveRecord(raw, checkpoint.strings, checkpoint.strings, id, student, found))
+    {
+        return false;
+    }
+    roster.clear();
+    if (found)
+    {
+        roster[id] = std::move(student);
+    }
+    return true;
+}
+
+std::vector<Student> getRosterAsOf(std::time_t time)
+{
+    std::vector<Student> result;
+    flushBackgroundPersistence();
+    std::lock_guard<std::mutex> lock(gradeHistory.checkpointMutex);
+    auto checkpoint = std::upper_bound(gradeHistory.checkpoints.begin(), gradeHistory.checkpoints.end(), time,
+        [](std::time_t value, const GradeCheckpoint& c)
+        { return value < c.time; });
+    if (checkpoint == gradeHistory.checkpoints.begin())
+    {
+        std::cerr << "Error: No history recorded before the requested time.\n";
+        return result;
+    }
+    --checkpoint;
+
+    std::map<int, Student> roster;
+    if (!restoreGradeCheckpoint(*checkpoint, roster))
+    {
+        std::cerr << "Error: Grade history checkpoint is corrupt.\n";
+        return result;
+    }
+
+    size_t end = checkpoint + 1 != gradeHistory.checkpoints.end()
+        ? (checkpoint + 1)->logOffset : gradeHistory.log.size();
+    size_t pos = checkpoint->logOffset;
+    std::time_t changeTime = checkpoint->time;
+    GradeChange change;
+    while (pos < end && readGradeChange(gradeHistory.log, pos, changeTime, change) && change.time <= time)
+    {
+        applyGradeChange(change, roster);
+    }
+
+    for (auto& entry : roster)
+    {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+std::vector<GradeHistoryEntry> getGradeHistory(int id)
+{
+    std::vector<GradeHistoryEntry> history;
+    flushBackgroundPersistence();
+    std::lock_guard<std::mutex> lock(gradeHistory.checkpointMutex);
+    std::map<int, Student> roster;
+    size_t pos = 0;
+    std::time_t changeTime = 0;
+    GradeChange change;
+
+    for (size_t i = 0; i < gradeHistory.checkpoints.size(); ++i)
+    {
+        const GradeCheckpoint& checkpoint = gradeHistory.checkpoints[i];
+        if (checkpoint.replacesRoster)
+        {
+            if (!restoreGradeCheckpointRecord(checkpoint, id, roster))
+            {
+                std::cerr << "Error: Grade history checkpoint is corrupt.\n";
+                return history;
+            }
+            bool present = !roster.empty();
+            bool wasPresent = !history.empty() && history.back().present;
+            if (present != wasPresent ||
+                (present && !isSameStudentRecord(history.back().student, roster.begin()->second)))
+            {
+                history.push_back({ checkpoint.time, present, present ? roster.begin()->second : Student() });
+            }
+        }
+
+        pos = checkpoint.logOffset;
+        changeTime = checkpoint.time;
+        size_t end = i + 1 < gradeHistory.checkpoints.size()
+            ? gradeHistory.checkpoints[i + 1].logOffset : gradeHistory.log.size();
+        while (pos < end && readGradeChange(gradeHistory.log, pos, changeTime, change))
+        {
+            if (change.id == id)
+            {
+                applyGradeChange(change, roster);
+                bool present = !roster.empty();
+                history.push_back({ change.time, present, present ? roster.begin()->second : Student() });
+            }
+        }
+    }
+    return history;
+}
+
+std::vector<TranscriptSegment> parseTranscriptTemplate(const std::string& text)
+{
+    static const std::map<std::string, TranscriptField> fields = {
+        { "name", TranscriptField::Name },
+        { "id", TranscriptField::Id },
+        { "department", TranscriptField::Department },
+        { "major", TranscriptField::Major },
+        { "score1", TranscriptField::Score1 },
+        { "score2", TranscriptField::Score2 },
+        { "score3", TranscriptField::Score3 },
+        { "score4", TranscriptField::Score4 },
+        { "score5", TranscriptField::Score5 },
+        { "total", TranscriptField::Total },
+        { "average", TranscriptField::Average } };
+
+    std::vector<TranscriptSegment> segments;
+    std::string literal;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        size_t open = text.find('{', pos);
+        size_t close = open == std::string::npos ? std::string::npos : text.find('}', open);
+        if (close == std::string::npos)
+        {
+            literal.append(text, pos, std::string::npos);
+            break;
+        }
+
+        auto field = fields.find(text.substr(open + 1, close - open - 1));
+        if (field == fields.end())
+        {
+            literal.append(text, pos, open + 1 - pos);
+            pos = open + 1;
+            continue;
+        }
+        literal.append(text, pos, open - pos);
+        segments.push_back({ std::move(literal), field->second });
+        literal.clear();
+        pos = close + 1;
+    }
+    segments.push_back({ std::move(literal), TranscriptField::None });
+    return segments;
+}
+
+void renderTranscript(const std::vector<TranscriptSegment>& segments, const Student& student,
+    std::string& buffer)
+{
+    char number[32];
+    for (const auto& segment : segments)
+    {
+        buffer += segment.literal;
+        switch (segment.field)
+        {
+        case TranscriptField::None:
+            break;
+        case TranscriptField::Name:
+            buffer += student.name;
+            break;
+        case TranscriptField::Id:
+            buffer += std::to_string(student.id);
+            break;
+        case TranscriptField::Department:
+            buffer += student.department;
+            break;
+        case TranscriptField::Major:
+            buffer += student.major;
+            break;
+        case TranscriptField::Total:
+            buffer += std::to_string(getTotalScore(&student));
+            break;
+        case TranscriptField::Average:
+            std::snprintf(number, sizeof(number), "%.2f", getAverageScore(&student));
+            buffer += number;
+            break;
+        default:
+            buffer += std::to_string(student.scores[static_cast<int>(segment.field) -
+                static_cast<int>(TranscriptField::Score1)]);
+        }
+    }
+}
+
+void pushTranscriptBatch(TranscriptQueue& queue, TranscriptBatch* batch)
+{
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.batches.push_back(batch);
+    }
+    queue.ready.notify_one();
+}
+
+TranscriptBatch* popTranscriptBatch(TranscriptQueue& queue)
+{
+    std::unique_lock<std::mutex> lock(queue.mutex);
+    queue.ready.wait(lock, [&queue]()
+        { return !queue.batches.empty() || queue.producers == 0; });
+    if (queue.batches.empty())
+    {
+        return nullptr;
+    }
+    TranscriptBatch* batch = queue.batches.front();
+    queue.batches.pop_front();
+    return batch;
+}
+
+void closeTranscriptQueue(TranscriptQueue& queue)
+{
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        --queue.producers;
+    }
+    queue.ready.notify_all();
+}
+
+bool generateTranscripts(const std::string& templateFilename, const std::string& outputPrefix,
+    const std::string& department)
+{
+    std::string templateText = defaultTranscriptTemplate;
+    if (!templateFilename.empty())
+    {
+        std::ifstream templateFile(templateFilename);
+        if (!templateFile)
+        {
+            std::cerr << "Error: Unable to open file " << templateFilename << " for reading.\n";
+            return false;
+        }
+        std::ostringstream contents;
+        contents << templateFile.rdbuf();
+        templateText = contents.str();
+    }
+    const std::vector<TranscriptSegment> segments = parseTranscriptTemplate(templateText);
+
+    std::vector<const Student*> selected;
+    for (const auto& student : students)
+    {
+        if (department.empty() || student.department == department)
+        {
+            selected.push_back(&student);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t rendererCount = std::max<size_t>(1, std::thread::hardware_concurrency());
+    size_t writerCount = std::max<size_t>(1, rendererCount / 4);
+    size_t batchCount = (selected.size() + transcriptBatchRecords - 1) / transcriptBatchRecords;
+
+    std::vector<TranscriptBatch> storage(2 * (rendererCount + writerCount));
+    TranscriptQueue freeBatches, filledBatches;
+    freeBatches.producers = writerCount;
+    filledBatches.producers = rendererCount;
+    for (auto& batch : storage)
+    {
+        freeBatches.batches.push_back(&batch);
+    }
+
+    std::atomic<size_t> nextBatch(0);
+    std::atomic<size_t> written(0), failed(0);
+    std::vector<std::thread> renderers, writers;
+    for (size_t i = 0; i < rendererCount; ++i)
+    {
+        renderers.emplace_back([&]()
+            {
+                size_t index;
+                while ((index = nextBatch.fetch_add(1)) < batchCount)
+                {
+                    TranscriptBatch* batch = popTranscriptBatch(freeBatches);
+                    batch->first = index * transcriptBatchRecords;
+                    batch->count = std::min(transcriptBatchRecords, selected.size() - batch->first);
+                    batch->text.clear();
+                    batch->ends.clear();
+                    for (size_t j = 0; j < batch->count; ++j)
+                    {
+                        renderTranscript(segments, *selected[batch->first + j], batch->text);
+                        batch->ends.push_back(batch->text.size());
+                    }
+                    pushTranscriptBatch(filledBatches, batch);
+                }
+                closeTranscriptQueue(filledBatches);
+            });
+    }
+    for (size_t i = 0; i < writerCount; ++i)
+    {
+        writers.emplace_back([&]()
+            {
+                TranscriptBatch* batch;
+                while ((batch = popTranscriptBatch(filledBatches)) != nullptr)
+                {
+                    size_t begin = 0;
+                    for (size_t j = 0; j < batch->count; ++j)
+                    {
+                        std::ofstream outFile(outputPrefix + std::to_string(selected[batch->first + j]->id) + ".txt");
+                        outFile.write(batch->text.data() + begin, batch->ends[j] - begin);
+                        outFile.close();
+                        ++(outFile ? written : failed);
+                        begin = batch->ends[j];
+                    }
+                    pushTranscriptBatch(freeBatches, batch);
+                }
+                closeTranscriptQueue(freeBatches);
+            });
+    }
+    for (auto& renderer : renderers)
+    {
+        renderer.join();
+    }
+    for (auto& writer : writers)
+    {
+        writer.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::streamsize precision = std::cout.precision();
+    std::cout << "Generated " << written << " transcripts with prefix " << outputPrefix << " in "
+        << std::fixed << std::setprecision(2) << seconds * 1000 << " ms ("
+        << (seconds > 0 ? written / seconds : 0.0) << " transcripts/s).\n"
+        << std::defaultfloat << std::setprecision(precision);
+    if (failed > 0)
+    {
+        std::cerr << "Error: Unable to write " << failed << " transcript files.\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    clearScreen();
+    std::cout << "Welcome to Student Management System\n";
+    std::cout << "Please maximize the console window to ensure proper display and prevent formatting issues." << std::endl;
+
+    if (argc > 1 && std::string(argv[1]) == "--lazy")
+    {
+        std::string filename = argc > 2 ? argv[2] : "students.dat";
+        std::cout << "Indexing data from " << filename << "...\n";
+        browseLazyRegistry(filename, true);
+        clearScreen();
+        return 0;
+    }
+
+    std::cout << "Loading data from students.dat...\n";
+    loadStudentsFromFile("students.dat");
+    startBackgroundPersistence("students.dat");
+    startGradeHistory(gradeHistoryFilename);
+
+    int choice;
+    while (true)
+    {
+        checkBackgroundPersistence();
+        displayMainMenu();
+        if (!(std::cin >> choice))
+        {
+            clearScreen();
+            std::cerr << "Invalid input. Please enter a number.\n";
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            waitForEnter();
+            continue;
+        }
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        switch (choice)
+        {
+        case 1:
+        {
+            clearScreen();
+            std::string name, department, major;
+            int id;
+            std::vector<int> scores(5);
+
+            std::cout << "Enter name: ";
+            std::getline(std::cin, name);
+
+            std::cout << "Enter ID: ";
+            std::cin >> id;
+            std::cout << "Enter department: ";
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::getline(std::cin, department);
+
+            std::cout << "Enter major: ";
+            std::getline(std::cin, major);
+
+            std::cout << "Enter scores (5 courses): ";
+            for (int i = 0; i < 5; ++i)
+            {
+                std::cin >> scores[i];
+            }
+
+            if (addStudent(name, id, department, major, scores))
+            {
+                queueStudentUpsert(students.back());
+                waitForEnter();
+            }
+            break;
+        }
+        case 2:
+        {
+            displayDeleteStudentMenu();
+            std::cin >> choice;
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            clearScreen();
+            switch (choice)
+            {
+            case 1:
+            {
+                std::string name;
+                int deletedId;
+                std::cout << "Enter name: ";
+                std::getline(std::cin, name);
+                if (deleteStudentByName(name, deletedId))
+                {
+                    queueStudentRemovalById(deletedId);
+                    waitForEnter();
+                }
+                break;
+            }
+            case 2:
+            {
+                int id;
+                std::cout << "Enter ID: ";
+                std::cin >> id;
+                if (deleteStudentById(id))
                 {
-                    saveStudentsToFile("students.dat");
+                    queueStudentRemovalById(id);
+                    waitForEnter();
                 }
                 break;
             }
@@ -605,7 +3596,8 @@ int main()
                 }
                 if (modifyStudentByName(name, department, major, scores))
                 {
-                    saveStudentsToFile("students.dat");
+                    queueStudentUpsert(*findStudentByName(name));
+                    waitForEnter();
                 }
                 break;
             }
@@ -628,7 +3620,8 @@ int main()
                 }
                 if (modifyStudentById(id, department, major, scores))
                 {
-                    saveStudentsToFile("students.dat");
+                    queueStudentUpsert(*findStudentById(id));
+                    waitForEnter();
                 }
                 break;
             }
@@ -789,9 +3782,205 @@ int main()
         case 7:
             clearScreen();
             std::cout << "Exiting program...\n";
-            saveStudentsToFile("students.dat");
+            queueRosterSnapshot();
+            if (stopBackgroundPersistence())
+            {
+                std::cout << "Data saved to students.dat.\n";
+            }
+            else
+            {
+                std::cerr << "Error: Unable to write file students.dat.\n";
+            }
+            if (persistence.historyWriteFailed)
+            {
+                std::cerr << "Error: Unable to write file " << gradeHistoryFilename << ".\n";
+            }
+            waitForEnter();
             clearScreen();
             return 0;
+        case 8:
+        {
+            displayDataToolsMenu();
+            std::cin >> choice;
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            clearScreen();
+            switch (choice)
+            {
+            case 1:
+                saveStudentsToShards(shardManifestFilename);
+                break;
+            case 2:
+                if (loadStudentsFromShards(shardManifestFilename))
+                {
+                    queueRosterSnapshot();
+                    recordRosterReplaced();
+                }
+                break;
+            case 3:
+            {
+                std::string department;
+                std::cout << "Enter department: ";
+                std::getline(std::cin, department);
+                printStudentTable(queryShards(department,
+                    [](const Student&)
+                    { return true; }));
+                waitForEnter();
+                break;
+            }
+            case 4:
+            {
+                int id;
+                Student student;
+                std::cout << "Enter ID: ";
+                std::cin >> id;
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                if (findStudentInShards(id, student))
+                {
+                    printStudentTable({ student });
+                }
+                waitForEnter();
+                break;
+            }
+            case 5:
+            {
+                std::string filename;
+                std::cout << "Enter registry file: ";
+                std::getline(std::cin, filename);
+                browseLazyRegistry(filename, false);
+                break;
+            }
+            case 6:
+            {
+                std::string filename;
+                std::cout << "Enter archive file: ";
+                std::getline(std::cin, filename);
+                saveStudentsToArchive(filename);
+                break;
+            }
+            case 7:
+            {
+                std::string filename;
+                std::cout << "Enter archive file: ";
+                std::getline(std::cin, filename);
+                if (loadStudentsFromArchive(filename))
+                {
+                    queueRosterSnapshot();
+                    recordRosterReplaced();
+                }
+                break;
+            }
+            case 8:
+            {
+                std::string filename;
+                int id;
+                Student student;
+                std::cout << "Enter archive file: ";
+                std::getline(std::cin, filename);
+                std::cout << "Enter ID: ";
+                std::cin >> id;
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                if (readArchivedStudent(filename, id, student))
+                {
+                    printStudentTable({ student });
+                }
+                waitForEnter();
+                break;
+            }
+            case 9:
+            {
+                std::string baseFilename, otherFilename, diffFilename;
+                RosterDiffSummary summary;
+                std::cout << "Enter base roster file: ";
+                std::getline(std::cin, baseFilename);
+                std::cout << "Enter other roster file: ";
+                std::getline(std::cin, otherFilename);
+                std::cout << "Enter diff output file: ";
+                std::getline(std::cin, diffFilename);
+                if (diffRosterFiles(baseFilename, otherFilename, diffFilename, summary))
+                {
+                    std::cout << "Diff written to " << diffFilename << ": " << summary.added << " added, "
+                        << summary.removed << " removed, " << summary.changed << " changed.\n";
+                }
+                waitForEnter();
+                break;
+            }
+            case 10:
+            {
+                std::string diffFilename;
+                RosterDiffSummary summary;
+                std::cout << "Enter diff file: ";
+                std::getline(std::cin, diffFilename);
+                if (applyRosterDiff(diffFilename, summary))
+                {
+                    std::cout << "Diff applied: " << summary.added << " added, "
+                        << summary.removed << " removed, " << summary.changed << " changed.\n";
+                    queueRosterSnapshot();
+                    recordRosterReplaced();
+                }
+                waitForEnter();
+                break;
+            }
+            case 11:
+            {
+                long long secondsAgo;
+                std::cout << "Enter how many seconds ago: ";
+                std::cin >> secondsAgo;
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::time_t asOf = std::time(nullptr) - static_cast<std::time_t>(secondsAgo);
+                printStudentTable(getRosterAsOf(asOf));
+                waitForEnter();
+                break;
+            }
+            case 12:
+            {
+                int id;
+                std::cout << "Enter ID: ";
+                std::cin >> id;
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::vector<GradeHistoryEntry> history = getGradeHistory(id);
+                if (history.empty())
+                {
+                    std::cerr << "Error: No history recorded for student with ID " << id << ".\n";
+                }
+                std::time_t now = std::time(nullptr);
+                for (const auto& entry : history)
+                {
+                    std::cout << "\n" << static_cast<long long>(now - entry.time) << " seconds ago: ";
+                    if (entry.present)
+                    {
+                        std::cout << "\n";
+                        printStudentTable({ entry.student });
+                    }
+                    else
+                    {
+                        std::cout << "removed\n";
+                    }
+                }
+                waitForEnter();
+                break;
+            }
+            case 13:
+            {
+                std::string templateFilename, outputPrefix, department;
+                std::cout << "Enter template file (leave empty for default): ";
+                std::getline(std::cin, templateFilename);
+                std::cout << "Enter output file prefix: ";
+                std::getline(std::cin, outputPrefix);
+                std::cout << "Enter department (leave empty for all): ";
+                std::getline(std::cin, department);
+                generateTranscripts(templateFilename, outputPrefix, department);
+                waitForEnter();
+                break;
+            }
+            case 14:
+                break;
+            default:
+                clearScreen();
+                std::cout << "Invalid choice.\n";
+                waitForEnter();
+            }
+            break;
+        }
         default:
             clearScreen();
             std::cout << "Invalid choice.\n";